@@ -0,0 +1,36 @@
+QT += core concurrent
+
+TARGET = bench_qcvimg
+TEMPLATE = app
+
+CONFIG += c++17 console
+CONFIG -= app_bundle debug_and_release
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# Directory of the built QCVimgLib, defaults to a sibling build of src/QCVimgLib.pro
+isEmpty(QCVIMGLIB_DIR) {
+    QCVIMGLIB_DIR = $$OUT_PWD/../src
+}
+
+INCLUDEPATH += ../src
+LIBS += -L$$QCVIMGLIB_DIR -lQCVimgLib
+unix: QMAKE_RPATHDIR += $$QCVIMGLIB_DIR
+
+SOURCES += \
+    bench_qcvimg.cpp \
+
+win32: {
+    include("c:/dev/opencv/opencv.pri")
+    LIBS += -lbenchmark -lshlwapi
+}
+
+unix: !macx {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += opencv4 benchmark
+}
+
+unix: macx {
+    INCLUDEPATH += "/usr/local/include"
+    LIBS += -L"/usr/local/lib" -lopencv_world -lbenchmark
+}
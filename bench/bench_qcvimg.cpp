@@ -0,0 +1,404 @@
+﻿#include <benchmark/benchmark.h>
+
+#include "qcvimg.h"
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QImage>
+#include <opencv4/opencv2/core.hpp>
+#include <opencv4/opencv2/core/mat.hpp>
+
+#include <array>
+
+
+namespace {
+
+const std::array<QImage::Format, 6> scFormats {
+    QImage::Format_RGB32,
+    QImage::Format_ARGB32,
+    QImage::Format_RGB888,
+    QImage::Format_Alpha8,
+    QImage::Format_Grayscale8,
+    QImage::Format_Grayscale16
+};
+
+const std::array<QSize, 4> scSizes {
+    QSize(640, 480),    // VGA
+    QSize(1920, 1080),  // 1080p
+    QSize(3840, 2160),  // 4K
+    QSize(7680, 4320)   // 8K
+};
+
+QImage::Format formatArg(const benchmark::State& state)
+{
+    return scFormats[static_cast<size_t>(state.range(0))];
+}
+
+QSize sizeArg(const benchmark::State& state)
+{
+    return scSizes[static_cast<size_t>(state.range(1))];
+}
+
+// A target format with a different layout for every supported format
+QImage::Format conversionTarget(QImage::Format format)
+{
+    switch (format) {
+        case QImage::Format_RGB888:
+            return QImage::Format_ARGB32;
+        case QImage::Format_Grayscale16:
+            return QImage::Format_Grayscale8;
+        default:
+            return QImage::Format_RGB888;
+    }
+}
+
+QCVimg createImage(const benchmark::State& state)
+{
+    const QSize size = sizeArg(state);
+    QCVimg img(size.width(), size.height(), formatArg(state));
+    img.fill(QColor(40, 120, 200));
+
+    return img;
+}
+
+void setProcessedBytes(benchmark::State& state, const QCVimg& img)
+{
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * img.qImg().sizeInBytes());
+    state.SetLabel(QString("%1x%2").arg(img.width()).arg(img.height()).toStdString());
+}
+
+// Runs every benchmark with all format and size combinations
+void formatsAndSizes(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->ArgNames({"format", "size"});
+
+    for (size_t format = 0; format < scFormats.size(); ++format) {
+        for (size_t size = 0; size < scSizes.size(); ++size) {
+            benchmark->Args({static_cast<int64_t>(format), static_cast<int64_t>(size)});
+        }
+    }
+
+    benchmark->Unit(benchmark::kMicrosecond);
+}
+
+} // namespace
+
+
+static void BM_ConstructWithSize(benchmark::State& state)
+{
+    const QSize size = sizeArg(state);
+    const QImage::Format format = formatArg(state);
+
+    for (auto _ : state) {
+        QCVimg img(size.width(), size.height(), format);
+        benchmark::DoNotOptimize(img.cvMat().data);
+    }
+
+    setProcessedBytes(state, createImage(state));
+}
+BENCHMARK(BM_ConstructWithSize)->Apply(formatsAndSizes);
+
+static void BM_ConstructFromQImage(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+
+    for (auto _ : state) {
+        QCVimg img(source.qImg());
+        benchmark::DoNotOptimize(img.cvMat().data);
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_ConstructFromQImage)->Apply(formatsAndSizes);
+
+static void BM_ConstructFromMovedQImage(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        QImage qImg = source.qImg().copy();
+        state.ResumeTiming();
+
+        QCVimg img(std::move(qImg));
+        benchmark::DoNotOptimize(img.cvMat().data);
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_ConstructFromMovedQImage)->Apply(formatsAndSizes);
+
+static void BM_ConstructFromMat(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+    const cv::Mat sourceMat = source.cvMat();
+
+    for (auto _ : state) {
+        QCVimg img(sourceMat, MatColorOrder::BGR);
+        benchmark::DoNotOptimize(img.cvMat().data);
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_ConstructFromMat)->Apply(formatsAndSizes);
+
+static void BM_ConstructFromMovedMat(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        cv::Mat sourceMat = source.cvMat().clone();
+        state.ResumeTiming();
+
+        QCVimg img(std::move(sourceMat), MatColorOrder::BGR);
+        benchmark::DoNotOptimize(img.cvMat().data);
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_ConstructFromMovedMat)->Apply(formatsAndSizes);
+
+static void BM_CopyConstruct(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+
+    for (auto _ : state) {
+        QCVimg img(source);
+        benchmark::DoNotOptimize(img.cvMat().data);
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_CopyConstruct)->Apply(formatsAndSizes);
+
+static void BM_CopyFromQImage(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+    QCVimg img;
+
+    for (auto _ : state) {
+        img.copy(source.qImg());
+        benchmark::DoNotOptimize(img.cvMat().data);
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_CopyFromQImage)->Apply(formatsAndSizes);
+
+static void BM_CopyFromMat(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+    const cv::Mat sourceMat = source.cvMat();
+    QCVimg img;
+
+    for (auto _ : state) {
+        img.copy(sourceMat, MatColorOrder::BGR);
+        benchmark::DoNotOptimize(img.cvMat().data);
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_CopyFromMat)->Apply(formatsAndSizes);
+
+static void BM_CopyToMat(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+    cv::Mat dest;
+
+    for (auto _ : state) {
+        source.copyTo(dest);
+        benchmark::DoNotOptimize(dest.data);
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_CopyToMat)->Apply(formatsAndSizes);
+
+static void BM_CopyToQImage(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+    QImage dest;
+
+    for (auto _ : state) {
+        source.copyTo(dest);
+        benchmark::DoNotOptimize(dest.constBits());
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_CopyToQImage)->Apply(formatsAndSizes);
+
+static void BM_ConvertToFormat(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+    const QImage::Format target = conversionTarget(source.qImg().format());
+
+    for (auto _ : state) {
+        QCVimg converted = source.convertToFormat(target);
+        benchmark::DoNotOptimize(converted.cvMat().data);
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_ConvertToFormat)->Apply(formatsAndSizes);
+
+static void BM_ResizeQt(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+
+    for (auto _ : state) {
+        QCVimg resized = source.resize(source.width() / 2, source.height() / 2,
+                                       Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        benchmark::DoNotOptimize(resized.cvMat().data);
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_ResizeQt)->Apply(formatsAndSizes);
+
+static void BM_ResizeOpenCV(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+
+    for (auto _ : state) {
+        QCVimg resized = source.resize(source.width() / 2, source.height() / 2, ResizeInterpolation::Area);
+        benchmark::DoNotOptimize(resized.cvMat().data);
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_ResizeOpenCV)->Apply(formatsAndSizes);
+
+static void BM_RebindMat(benchmark::State& state)
+{
+    QCVimg img = createImage(state);
+
+    for (auto _ : state) {
+        img.rebindMat();
+        benchmark::DoNotOptimize(img.cvMat().data);
+    }
+
+    setProcessedBytes(state, img);
+}
+BENCHMARK(BM_RebindMat)->Apply(formatsAndSizes);
+
+static void BM_RebindQImg(benchmark::State& state)
+{
+    QCVimg img = createImage(state);
+    const cv::Mat sourceMat = img.cvMat().clone();
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        img.cvMat() = sourceMat.clone();
+        state.ResumeTiming();
+
+        img.rebindQImg(DataPrio::Low, MatColorOrder::BGR);
+        benchmark::DoNotOptimize(img.qImg().constBits());
+    }
+
+    setProcessedBytes(state, img);
+}
+BENCHMARK(BM_RebindQImg)->Apply(formatsAndSizes);
+
+static void BM_SwapMatRedBlue(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+
+    if (source.cvMat().channels() < 3) {
+        state.SkipWithError("swapMatRedBlue requires three or four channels");
+        return;
+    }
+
+    cv::Mat dest;
+
+    for (auto _ : state) {
+        QCVimg::swapMatRedBlue(source.cvMat(), dest);
+        benchmark::DoNotOptimize(dest.data);
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_SwapMatRedBlue)->Apply(formatsAndSizes);
+
+static void BM_StreamWriteRaw(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+    QByteArray data;
+
+    for (auto _ : state) {
+        data.clear();
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        QDataStream ds(&buffer);
+        ds << source;
+        benchmark::DoNotOptimize(data.constData());
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_StreamWriteRaw)->Apply(formatsAndSizes);
+
+static void BM_StreamReadRaw(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+    QByteArray data;
+    QBuffer writeBuffer(&data);
+    writeBuffer.open(QIODevice::WriteOnly);
+    QDataStream writeStream(&writeBuffer);
+    writeStream << source;
+    QCVimg img;
+
+    for (auto _ : state) {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+        QDataStream ds(&buffer);
+        ds >> img;
+        benchmark::DoNotOptimize(img.cvMat().data);
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_StreamReadRaw)->Apply(formatsAndSizes);
+
+static void BM_StreamWritePng(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+    QByteArray data;
+
+    for (auto _ : state) {
+        data.clear();
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        QDataStream ds(&buffer);
+        source.writeTo(ds, StreamEncoding::Png);
+        benchmark::DoNotOptimize(data.constData());
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_StreamWritePng)->Apply(formatsAndSizes);
+
+static void BM_StreamReadPng(benchmark::State& state)
+{
+    const QCVimg source = createImage(state);
+    QByteArray data;
+    QBuffer writeBuffer(&data);
+    writeBuffer.open(QIODevice::WriteOnly);
+    QDataStream writeStream(&writeBuffer);
+    source.writeTo(writeStream, StreamEncoding::Png);
+    QCVimg img;
+
+    for (auto _ : state) {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+        QDataStream ds(&buffer);
+        ds >> img;
+        benchmark::DoNotOptimize(img.cvMat().data);
+    }
+
+    setProcessedBytes(state, source);
+}
+BENCHMARK(BM_StreamReadPng)->Apply(formatsAndSizes);
+
+BENCHMARK_MAIN();
@@ -1,4 +1,4 @@
-QT += core
+QT += core concurrent
 
 TARGET = QCVimgLib
 TEMPLATE = lib
@@ -9,15 +9,55 @@ CONFIG -= debug_and_release
 DEFINES += QT_DEPRECATED_WARNINGS
 DEFINES += QCVIMGLIB_LIBRARY
 
+# Uncomment to collect the instrumentation counters (see qcvimgstats.h)
+# DEFINES += QCVIMG_ENABLE_STATS
+
 HEADERS += \
     qcvimg.h \
+    qcvimgbatch.h \
+    qcvimgconstref.h \
+    qcvimgcore.h \
+    qcvimgexecution.h \
+    qcvimgfill.h \
     qcvimglib_decl.h \
+    qcvimgpipeline.h \
+    qcvimgpixel.h \
+    qcvimgpool.h \
+    qcvimgpyramid.h \
+    qcvimgqueue.h \
+    qcvimgreader.h \
+    qcvimgstats.h \
+    qcvimgstore.h \
+    qcvimgswizzle.h \
+    qcvimgtriplebuffer.h \
+    qcvimgview.h \
 
 
 
 SOURCES += \
     qcvimg.cpp \
+    qcvimgbatch.cpp \
+    qcvimgconstref.cpp \
+    qcvimgcore.cpp \
+    qcvimgexecution.cpp \
+    qcvimgfill.cpp \
+    qcvimgpipeline.cpp \
+    qcvimgpool.cpp \
+    qcvimgpyramid.cpp \
+    qcvimgqueue.cpp \
+    qcvimgreader.cpp \
+    qcvimgstats.cpp \
+    qcvimgstore.cpp \
+    qcvimgswizzle.cpp \
+    qcvimgtriplebuffer.cpp \
+    qcvimgview.cpp \
 
+# Video frame and DMABUF import (see qcvimgvideo.h), only with Qt Multimedia
+qtHaveModule(multimedia) {
+    QT += multimedia
+    HEADERS += qcvimgvideo.h
+    SOURCES += qcvimgvideo.cpp
+}
     
 win32: {
     include("c:/dev/opencv/opencv.pri")
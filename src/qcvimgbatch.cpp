@@ -0,0 +1,167 @@
+﻿#include "qcvimgbatch.h"
+#include "qcvimgexecution.h"
+#include "qcvimgswizzle.h"
+
+#include <opencv2/core/utility.hpp>
+
+
+namespace {
+
+const int scSlabAlignment = 64;
+
+size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+}
+
+struct QCVimgBatch::Slab
+{
+    explicit Slab(size_t bytes)
+        : data(static_cast<uchar*>(qMallocAligned(bytes, scSlabAlignment))) {}
+
+    ~Slab()
+    {
+        qFreeAligned(data);
+    }
+
+    Slab(const Slab&) = delete;
+    Slab& operator=(const Slab&) = delete;
+
+    uchar* data;
+};
+
+
+QCVimgBatch QCVimgBatch::fromMats(const std::vector<cv::Mat>& mats, MatColorOrder sourceColorOrder)
+{
+    if (mats.empty() || !QCVimg::isValidMatFormat(mats.front().type()) || mats.front().dims != 2) {
+        return QCVimgBatch();
+    }
+
+    const cv::Mat& first = mats.front();
+
+    for (const auto& mat : mats) {
+        if (mat.type() != first.type() || mat.size() != first.size() || mat.dims != 2) {
+            return QCVimgBatch();
+        }
+    }
+
+    QCVimgBatch batch = allocate(static_cast<int>(mats.size()), first.cols, first.rows,
+                                 QCVimg::convertMatFormatTag(first.type()));
+    const bool swapRedBlue = sourceColorOrder == MatColorOrder::BGR && first.type() == CV_8UC3;
+
+    QCVimgExecution::current().parallelFor(cv::Range(0, batch.size()), [&](const cv::Range& frames) {
+        for (int i = frames.start; i < frames.end; ++i) {
+            if (swapRedBlue) {
+                QCVimgSwizzle::swapRedBlue(mats[i], batch.mFrames[i].cvMat());
+            } else {
+                mats[i].copyTo(batch.mFrames[i].cvMat());
+            }
+        }
+    });
+
+    return batch;
+}
+
+QCVimgBatch QCVimgBatch::fromImages(const std::vector<QCVimg>& images, QImage::Format format)
+{
+    if (images.empty() || !QCVimg::isValidQImgFormat(format)) {
+        return QCVimgBatch();
+    }
+
+    const QCVimg& first = images.front();
+
+    for (const auto& image : images) {
+        if (image.qImg().size() != first.qImg().size() || !image.isMatBound() || image.empty()) {
+            return QCVimgBatch();
+        }
+    }
+
+    QCVimgBatch batch = allocate(static_cast<int>(images.size()), first.width(), first.height(), format);
+
+    QCVimgExecution::current().parallelFor(cv::Range(0, batch.size()), [&](const cv::Range& frames) {
+        for (int i = frames.start; i < frames.end; ++i) {
+            images[i].convertInto(batch.mFrames[i], format);
+        }
+    });
+
+    return batch;
+}
+
+int QCVimgBatch::size() const
+{
+    return static_cast<int>(mFrames.size());
+}
+
+bool QCVimgBatch::empty() const
+{
+    return mFrames.empty();
+}
+
+QCVimg& QCVimgBatch::frame(int index)
+{
+    return mFrames[static_cast<size_t>(index)];
+}
+
+const QCVimg& QCVimgBatch::frame(int index) const
+{
+    return mFrames[static_cast<size_t>(index)];
+}
+
+QImage::Format QCVimgBatch::format() const
+{
+    return empty() ? QImage::Format_Invalid : mFrames.front().qFormat();
+}
+
+cv::Mat QCVimgBatch::blob() const
+{
+    if (empty()) {
+        return cv::Mat();
+    }
+
+    const QImage& first = mFrames.front().qImg();
+    const int sizes[] = {size(), first.height(), first.width()};
+    const size_t steps[] = {mFrameStride, static_cast<size_t>(first.bytesPerLine())};
+
+    return cv::Mat(3, sizes, QCVimg::convertQImgFormatTag(first.format()), mSlab->data, steps);
+}
+
+QCVimgBatch QCVimgBatch::allocate(int count, int width, int height, QImage::Format format)
+{
+    const int pixelBytes = QImage::toPixelFormat(format).bitsPerPixel() / 8;
+    // QImage expects 32 bit aligned scanlines
+    const int bytesPerLine = static_cast<int>(alignUp(static_cast<size_t>(width) * pixelBytes, 4));
+    const size_t frameStride = alignUp(static_cast<size_t>(bytesPerLine) * height, scSlabAlignment);
+
+    QCVimgBatch batch;
+    batch.mSlab = std::make_shared<Slab>(frameStride * count);
+
+    if (batch.mSlab->data == nullptr) {
+        return QCVimgBatch();
+    }
+
+    batch.mFrameStride = frameStride;
+    batch.mFrames.reserve(static_cast<size_t>(count));
+
+    for (int i = 0; i < count; ++i) {
+        auto slabReference = new std::shared_ptr<Slab>(batch.mSlab);
+        QImage frameQImg(batch.mSlab->data + frameStride * i, width, height, bytesPerLine, format,
+                         releaseSlabReference, slabReference);
+
+        if (frameQImg.isNull()) {
+            // QImage doesn't call the cleanup function if it couldn't be created
+            delete slabReference;
+            return QCVimgBatch();
+        }
+
+        batch.mFrames.emplace_back(std::move(frameQImg));
+    }
+
+    return batch;
+}
+
+void QCVimgBatch::releaseSlabReference(void* slabReference)
+{
+    delete static_cast<std::shared_ptr<Slab>*>(slabReference);
+}
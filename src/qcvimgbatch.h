@@ -0,0 +1,118 @@
+﻿#ifndef QCVIMGBATCH_H
+#define QCVIMGBATCH_H
+
+#include "qcvimglib_decl.h"
+#include "qcvimg.h"
+
+#include <memory>
+#include <vector>
+
+/**
+ * @brief A sequence of equally sized and formatted images stored in a single
+ * contiguous allocation.
+ *
+ * QCVimgBatch is meant for converting whole frame sequences (e.g. video GOPs
+ * or multi-camera bursts) at once. The format of the whole sequence is
+ * validated only once, all frames are allocated in one slab, and the per frame
+ * copy, swizzle or conversion is spread across the threads of the current
+ * QCVimgExecution.
+ *
+ * Each frame is a regular, bound QCVimg whose QImage member points into the
+ * slab, so frames can be used like any other QCVimg (copying a frame results
+ * in a regular deep copy outside of the slab). Since every frame has the same
+ * stride, the whole batch can also be viewed as a single N-dimensional
+ * cv::Mat (see #blob) without any re-packing. The slab is kept alive as long
+ * as the batch or any QImage referencing a frame exists.
+ *
+ * Batches are move-only, as a copy could no longer provide a contiguous view
+ * of its frames.
+ */
+class QCVIMGLIB_EXPORT QCVimgBatch
+{
+public:
+    /**
+     * @brief Creates an empty batch.
+     */
+    QCVimgBatch() = default;
+
+    QCVimgBatch(const QCVimgBatch&) = delete;
+    QCVimgBatch& operator=(const QCVimgBatch&) = delete;
+    QCVimgBatch(QCVimgBatch&&) = default;
+    QCVimgBatch& operator=(QCVimgBatch&&) = default;
+
+    /**
+     * @brief Creates a batch from a sequence of cv::Mat images with deep copy.
+     *
+     * All images in @p mats must have the same size and a compatible type,
+     * otherwise an empty batch is returned. The conversion into the QImage
+     * format follows the rules of the respective QCVimg constructor.
+     * @param mats Source images to copy from.
+     * @param sourceColorOrder Color order of all images in @p mats, see
+     * #MatColorOrder.
+     */
+    static QCVimgBatch fromMats(const std::vector<cv::Mat>& mats,
+                                MatColorOrder sourceColorOrder = MatColorOrder::RGB);
+
+    /**
+     * @brief Creates a batch from a sequence of QCVimg images, converting all
+     * of them to @p format.
+     *
+     * All images in @p images must be bound and have the same size, and
+     * @p format must be compatible, otherwise an empty batch is returned.
+     * The conversion follows the rules of QCVimg::convertInto.
+     * @param images Source images to convert.
+     * @param format Target format of all frames.
+     */
+    static QCVimgBatch fromImages(const std::vector<QCVimg>& images, QImage::Format format);
+
+    /**
+     * @brief Returns the number of frames in the batch.
+     */
+    int size() const;
+
+    /**
+     * @brief Tells if the batch has no frames.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Returns a reference to the frame at @p index.
+     *
+     * The same warnings apply as for QCVimg::qImg and QCVimg::cvMat: anything
+     * that reallocates the frame moves it out of the slab.
+     */
+    QCVimg& frame(int index);
+
+    /**
+     * @brief Returns a const reference to the frame at @p index.
+     */
+    const QCVimg& frame(int index) const;
+
+    /**
+     * @brief Returns the format shared by all frames.
+     */
+    QImage::Format format() const;
+
+    /**
+     * @brief Returns the whole batch as a single cv::Mat.
+     *
+     * The returned Mat has three dimensions (frames, rows, columns) and the
+     * channel count of the frame format, and points directly into the slab, so
+     * it can be passed to e.g. cv::dnn::blobFromImages without re-packing. The
+     * Mat doesn't hold a reference to the slab, so it must not outlive the
+     * batch. If frames are padded, the steps of the Mat reflect it.
+     */
+    cv::Mat blob() const;
+
+private:
+    struct Slab;
+
+    static QCVimgBatch allocate(int count, int width, int height, QImage::Format format);
+    static void releaseSlabReference(void* slabReference);
+
+    std::shared_ptr<Slab> mSlab;
+    std::vector<QCVimg> mFrames;
+    size_t mFrameStride = 0;
+};
+
+#endif // QCVIMGBATCH_H
@@ -0,0 +1,54 @@
+﻿#include "qcvimgconstref.h"
+#include "qcvimgcore.h"
+
+
+// constBits() doesn't detach, so the Mat points to the shared buffer
+QCVimgConstRef::QCVimgConstRef(const QImage& img, int matFormat)
+    : mQImg(img),
+      mMImg(mQImg.height(),
+            mQImg.width(),
+            matFormat,
+            const_cast<uchar*>(mQImg.constBits()),
+            static_cast<unsigned long>(mQImg.bytesPerLine()))
+{
+}
+
+const QImage& QCVimgConstRef::qImg() const
+{
+    return mQImg;
+}
+
+const cv::Mat& QCVimgConstRef::cvMat() const
+{
+    return mMImg;
+}
+
+QCVimgCore QCVimgConstRef::copy() const
+{
+    return QCVimgCore(mQImg);
+}
+
+bool QCVimgConstRef::empty() const
+{
+    return mQImg.isNull();
+}
+
+int QCVimgConstRef::matFormat() const
+{
+    return mMImg.type();
+}
+
+QImage::Format QCVimgConstRef::qFormat() const
+{
+    return mQImg.format();
+}
+
+int QCVimgConstRef::width() const
+{
+    return mQImg.width();
+}
+
+int QCVimgConstRef::height() const
+{
+    return mQImg.height();
+}
@@ -0,0 +1,90 @@
+﻿#ifndef QCVIMGCONSTREF_H
+#define QCVIMGCONSTREF_H
+
+#include "qcvimglib_decl.h"
+
+#include <QImage>
+#include <opencv4/opencv2/core/mat.hpp>
+
+class QCVimgCore;
+
+/**
+ * @brief A shared, read-only handle to the data of a QCVimgCore.
+ *
+ * The handle references the same buffer as the image it was created from
+ * (see QCVimgCore::share) instead of copying it, so handing one frame to
+ * several read-only consumers costs no more than a reference count increment
+ * each. Copying the handle is equally cheap, and handles can be passed to
+ * other threads.
+ *
+ * The data seen through the handle never changes: the handle only provides
+ * const access, and as soon as the original image is modified through any of
+ * the QCVimgCore functions (including the non-const #QCVimgCore::qImg and
+ * #QCVimgCore::cvMat accessors), the original image detaches from the shared
+ * buffer first. The buffer is released when the last handle (or image)
+ * referencing it is destroyed. When a modifiable image is needed, #copy
+ * creates a deep copy.
+ *
+ * _IMPORTANT:_ The guarantee only holds as long as the original image's
+ * cv::Mat member isn't copied out and modified separately (e.g. through a
+ * cv::Mat copy taken before calling QCVimgCore::share), as cv::Mat copies
+ * can't be tracked.
+ */
+class QCVIMGLIB_EXPORT QCVimgConstRef
+{
+public:
+    /**
+     * @brief Creates an empty handle.
+     */
+    QCVimgConstRef() = default;
+
+    /**
+     * @brief Returns a const reference to the QImage interface of the data.
+     */
+    const QImage& qImg() const;
+
+    /**
+     * @brief Returns a const reference to the cv::Mat interface of the data.
+     */
+    const cv::Mat& cvMat() const;
+
+    /**
+     * @brief Creates a deep copy of the referenced data.
+     */
+    QCVimgCore copy() const;
+
+    /**
+     * @brief Tells if the handle is empty.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Returns the image's format in OpenCV notation.
+     */
+    int matFormat() const;
+
+    /**
+     * @brief Returns the image's format in Qt notation.
+     */
+    QImage::Format qFormat() const;
+
+    /**
+     * @brief Returns the width of the image.
+     */
+    int width() const;
+
+    /**
+     * @brief Returns the height of the image.
+     */
+    int height() const;
+
+private:
+    friend class QCVimgCore;
+
+    QCVimgConstRef(const QImage& img, int matFormat);
+
+    QImage mQImg;
+    cv::Mat mMImg;
+};
+
+#endif // QCVIMGCONSTREF_H
@@ -0,0 +1,1721 @@
+﻿#include "qcvimgcore.h"
+#include "qcvimgfill.h"
+#include "qcvimgreader.h"
+#include "qcvimgswizzle.h"
+#include <opencv2/imgproc.hpp>
+
+#include <QFile>
+#include <QPainter>
+#include <QSharedMemory>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+
+const QMap<QString, QImage::Format> QCVimgCore::scmTextToQImgFormat = fillQImgFormatToStringMap();
+
+namespace {
+
+// Taking arrays lets the kernels run on both host Mats and device UMats (through OpenCL)
+using ConversionKernel = void (*)(cv::InputArray source, cv::OutputArray dest);
+
+struct FormatConversion
+{
+    QImage::Format sourceFormat;
+    QImage::Format destFormat;
+    ConversionKernel kernel;
+};
+
+// Weights of qGray() in the channel order of the source Mat
+const cv::Matx13f scRgbToGrayWeights(11.f / 32, 16.f / 32, 5.f / 32);
+const cv::Matx14f scBgraToGrayWeights(5.f / 32, 16.f / 32, 11.f / 32, 0.f);
+
+void convertRgbToBgra(cv::InputArray source, cv::OutputArray dest)
+{
+    cv::cvtColor(source, dest, cv::COLOR_RGB2BGRA);
+}
+
+void convertBgraToRgb(cv::InputArray source, cv::OutputArray dest)
+{
+    cv::cvtColor(source, dest, cv::COLOR_BGRA2RGB);
+}
+
+void convertBgraToOpaqueBgra(cv::InputArray source, cv::OutputArray dest)
+{
+    cv::bitwise_or(source, cv::Scalar(0, 0, 0, 255), dest);
+}
+
+void convertRgbToGray(cv::InputArray source, cv::OutputArray dest)
+{
+    cv::transform(source, dest, scRgbToGrayWeights);
+}
+
+void convertBgraToGray(cv::InputArray source, cv::OutputArray dest)
+{
+    cv::transform(source, dest, scBgraToGrayWeights);
+}
+
+void convertGrayToRgb(cv::InputArray source, cv::OutputArray dest)
+{
+    cv::cvtColor(source, dest, cv::COLOR_GRAY2RGB);
+}
+
+void convertGrayToBgra(cv::InputArray source, cv::OutputArray dest)
+{
+    cv::cvtColor(source, dest, cv::COLOR_GRAY2BGRA);
+}
+
+void convertDepth(cv::InputArray source, cv::OutputArray dest, int depth, double scale)
+{
+    if (source.isUMat()) {
+        source.getUMat().convertTo(dest, depth, scale);
+    } else {
+        source.getMat().convertTo(dest, depth, scale);
+    }
+}
+
+void convertGray16ToGray8(cv::InputArray source, cv::OutputArray dest)
+{
+    convertDepth(source, dest, CV_8U, 1.0 / 257);
+}
+
+void convertGray8ToGray16(cv::InputArray source, cv::OutputArray dest)
+{
+    convertDepth(source, dest, CV_16U, 257);
+}
+
+const FormatConversion scFormatConversions[] = {
+    {QImage::Format_RGB888, QImage::Format_ARGB32, convertRgbToBgra},
+    {QImage::Format_RGB888, QImage::Format_RGB32, convertRgbToBgra},
+    {QImage::Format_RGB888, QImage::Format_Grayscale8, convertRgbToGray},
+    {QImage::Format_ARGB32, QImage::Format_RGB888, convertBgraToRgb},
+    {QImage::Format_ARGB32, QImage::Format_RGB32, convertBgraToOpaqueBgra},
+    {QImage::Format_ARGB32, QImage::Format_Grayscale8, convertBgraToGray},
+    {QImage::Format_RGB32, QImage::Format_RGB888, convertBgraToRgb},
+    {QImage::Format_RGB32, QImage::Format_ARGB32, convertBgraToOpaqueBgra},
+    {QImage::Format_RGB32, QImage::Format_Grayscale8, convertBgraToGray},
+    {QImage::Format_Grayscale8, QImage::Format_RGB888, convertGrayToRgb},
+    {QImage::Format_Grayscale8, QImage::Format_ARGB32, convertGrayToBgra},
+    {QImage::Format_Grayscale8, QImage::Format_RGB32, convertGrayToBgra},
+    {QImage::Format_Grayscale8, QImage::Format_Grayscale16, convertGray8ToGray16},
+    {QImage::Format_Grayscale16, QImage::Format_Grayscale8, convertGray16ToGray8}
+};
+
+ConversionKernel findConversionKernel(QImage::Format sourceFormat, QImage::Format destFormat)
+{
+    for (const auto& conversion : scFormatConversions) {
+        if (conversion.sourceFormat == sourceFormat && conversion.destFormat == destFormat) {
+            return conversion.kernel;
+        }
+    }
+
+    return nullptr;
+}
+
+// The kernels work pixel by pixel, so the rows can be split into bands and
+// converted on the threads of the context (dest must already be allocated)
+void runConversionKernel(ConversionKernel kernel, const cv::Mat& source, cv::Mat& dest)
+{
+    const QCVimgExecution execution = QCVimgExecution::current();
+
+    if (execution.isDefault()) {
+        kernel(source, dest);
+        return;
+    }
+
+    execution.parallelFor(cv::Range(0, source.rows), [&](const cv::Range& rows) {
+        cv::Mat destRows = dest.rowRange(rows);
+        kernel(source.rowRange(rows), destRows);
+    });
+}
+
+// Size of the fields of the raw stream header, the rest of the header is padding
+const int scRawHeaderFieldBytes = 28;
+
+std::atomic<quint64> sDetachCount{0};
+std::atomic<quint64> sDeepCopyCount{0};
+
+// The copies counted by QCVimgCore::copyStats are always recorded through
+// these, so they are also recorded by QCVimgStats when that is compiled in
+void recordDeepCopy(qint64 bytes)
+{
+    sDeepCopyCount.fetch_add(1, std::memory_order_relaxed);
+    QCVIMG_STATS_RECORD(DeepCopy, bytes);
+}
+
+void recordDetach(qint64 bytes)
+{
+    sDetachCount.fetch_add(1, std::memory_order_relaxed);
+    QCVIMG_STATS_RECORD(Allocation, bytes);
+    QCVIMG_STATS_RECORD(DeepCopy, bytes);
+}
+
+// Formats keeping the blue channel first in memory
+bool isStoredAsBgr(QImage::Format format)
+{
+    switch (format) {
+        case QImage::Format_RGB32:
+        case QImage::Format_ARGB32:
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        case QImage::Format_BGR888:
+#endif
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Number of bytes of a scanline holding pixel data, without the padding
+int payloadBytesPerLine(const QImage& img)
+{
+    return (img.width() * img.depth() + 7) / 8;
+}
+
+bool imageDataEqual(const QImage& first, const QImage& second)
+{
+    if (first.size() != second.size() || first.format() != second.format()) {
+        return false;
+    }
+
+    if (first.isNull() || (first.constBits() == second.constBits() && first.bytesPerLine() == second.bytesPerLine())) {
+        return true;
+    }
+
+    if (!QCVimgCore::isValidQImgFormat(first.format())) {
+        return first == second;
+    }
+
+    const int lineBytes = payloadBytesPerLine(first);
+
+    if (first.format() == QImage::Format_RGB32) {
+        // The unused byte of RGB32 pixels can hold anything
+        for (int row = 0; row < first.height(); ++row) {
+            auto firstLine = reinterpret_cast<const quint32*>(first.constScanLine(row));
+            auto secondLine = reinterpret_cast<const quint32*>(second.constScanLine(row));
+            quint32 difference = 0;
+
+            for (int x = 0; x < first.width(); ++x) {
+                difference |= firstLine[x] ^ secondLine[x];
+            }
+
+            if ((difference & 0x00ffffff) != 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    if (first.bytesPerLine() == lineBytes && second.bytesPerLine() == lineBytes) {
+        return std::memcmp(first.constBits(), second.constBits(), static_cast<size_t>(first.sizeInBytes())) == 0;
+    }
+
+    for (int row = 0; row < first.height(); ++row) {
+        if (std::memcmp(first.constScanLine(row), second.constScanLine(row), static_cast<size_t>(lineBytes)) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t hashImageData(const QImage& img)
+{
+    size_t seed = qHash(static_cast<int>(img.format()));
+    seed = qHash(img.width(), seed);
+    seed = qHash(img.height(), seed);
+
+    if (img.isNull()) {
+        return seed;
+    }
+
+    const int lineBytes = payloadBytesPerLine(img);
+
+    if (img.format() == QImage::Format_RGB32) {
+        std::vector<quint32> maskedLine(static_cast<size_t>(img.width()));
+
+        for (int row = 0; row < img.height(); ++row) {
+            auto line = reinterpret_cast<const quint32*>(img.constScanLine(row));
+
+            for (int x = 0; x < img.width(); ++x) {
+                maskedLine[x] = line[x] | 0xff000000;
+            }
+
+            seed = qHashBits(maskedLine.data(), static_cast<size_t>(lineBytes), seed);
+        }
+    } else if (img.bytesPerLine() == lineBytes) {
+        seed = qHashBits(img.constBits(), static_cast<size_t>(img.sizeInBytes()), seed);
+    } else {
+        for (int row = 0; row < img.height(); ++row) {
+            seed = qHashBits(img.constScanLine(row), static_cast<size_t>(lineBytes), seed);
+        }
+    }
+
+    return seed;
+}
+
+// Scanline size of the raw format, aligned to 32 bits like in QImage
+qint64 rawBytesPerLine(int width, QImage::Format format)
+{
+    return (static_cast<qint64>(width) * QImage::toPixelFormat(format).bitsPerPixel() + 31) / 32 * 4;
+}
+
+}
+
+
+QCVimgCore::QCVimgCore(const QCVimgCore& img)
+    : mQImg(img.syncToHost().copy()), mCachedHash(img.mCachedHash), mHashCached(img.mHashCached),
+      mBindingMode(img.mBindingMode)
+{
+    QCVIMG_STATS_RECORD(Allocation, mQImg.sizeInBytes());
+    recordDeepCopy(mQImg.sizeInBytes());
+    createMatFromQImage(mQImg, mMImg);
+}
+
+QCVimgCore& QCVimgCore::operator=(const QCVimgCore& img)
+{
+    copyFrom(img.qImg());
+    mBindingMode = img.mBindingMode;
+
+    return *this;
+}
+
+QCVimgCore::QCVimgCore(QCVimgCore&& img) noexcept
+    : mQImg(std::move(img.mQImg)), mMImg(img.mMImg), mUMat(std::move(img.mUMat)),
+      mPendingMat(std::move(img.mPendingMat)), mCachedHash(img.mCachedHash), mHashCached(img.mHashCached),
+      mDeviceDirty(img.mDeviceDirty), mPendingRedBlueSwap(img.mPendingRedBlueSwap), mBindingMode(img.mBindingMode),
+      mDirtyRegion(std::move(img.mDirtyRegion)), mGeneration(img.mGeneration)
+{
+    // The pixmap cache is not moved along: a QPixmap must stay on the GUI thread,
+    // while images are moved between threads. The source releases it below.
+    img.mMImg = cv::Mat();
+    img.invalidateCaches();
+}
+
+QCVimgCore& QCVimgCore::operator=(QCVimgCore&& img) noexcept
+{
+    if (&img == this) {
+        return *this;
+    }
+
+    mQImg = std::move(img.mQImg);
+    mMImg = img.mMImg;
+    mUMat = std::move(img.mUMat);
+    mPendingMat = std::move(img.mPendingMat);
+    mCachedHash = img.mCachedHash;
+    mHashCached = img.mHashCached;
+    mDeviceDirty = img.mDeviceDirty;
+    mPendingRedBlueSwap = img.mPendingRedBlueSwap;
+    mBindingMode = img.mBindingMode;
+    mDirtyRegion = std::move(img.mDirtyRegion);
+    // Generations are only compared within one instance, so they must not go back
+    mGeneration = std::max(mGeneration, img.mGeneration) + 1;
+    // Like in the move constructor, the pixmap cache stays behind and is released
+    mCachedPix = QPixmap();
+    // QImage's move assignment swaps, which would leave this image's old buffer in img
+    img.mQImg = QImage();
+    img.mMImg = cv::Mat();
+    img.invalidateCaches();
+
+    return *this;
+}
+
+QCVimgCore::QCVimgCore(int width, int height, QImage::Format format)
+{
+    if (isValidQImgFormat(format)) {
+        mQImg = QImage(width, height, format);
+        createMatFromQImage(mQImg, mMImg);
+        QCVIMG_STATS_RECORD(Allocation, mQImg.sizeInBytes());
+    }
+}
+
+QCVimgCore::QCVimgCore(int width, int height, QImage::Format format, MatFormat matFormat)
+    : mQImg(width, height, format)
+{
+    mMImg = cv::Mat(mQImg.height(),
+                    mQImg.width(),
+                    matFormat,
+                    mQImg.bits(),
+                    static_cast<unsigned long>(mQImg.bytesPerLine()));
+    QCVIMG_STATS_RECORD(Allocation, mQImg.sizeInBytes());
+}
+
+QCVimgCore::QCVimgCore(const QImage& img)
+{
+    if (isValidQImgFormat(img.format())) {
+        copyFrom(img);
+    }
+}
+
+QCVimgCore::QCVimgCore(QImage&& img)
+{
+    if (isValidQImgFormat(img.format())) {
+        mQImg = std::move(img);
+        createMatFromQImage(mQImg, mMImg);
+    }
+}
+
+QCVimgCore::QCVimgCore(const cv::Mat& img, MatColorOrder sourceColorOrder)
+{
+    if (isValidMatFormat(img.type())) {
+        auto qImgFormat = convertMatFormatTag(img.type());
+        cv::Mat rgbMat;
+        getRgbMat(img, rgbMat, sourceColorOrder);
+        copyFrom(rgbMat, qImgFormat);
+    }
+}
+
+QCVimgCore::QCVimgCore(cv::Mat&& img, MatColorOrder sourceColorOrder, BindingMode bindingMode)
+    : mBindingMode(bindingMode)
+{
+    if (!isValidMatFormat(img.type())) {
+        return;
+    }
+
+    auto qImgFormat = convertMatFormatTag(img.type());
+
+    if (!isAdoptable(img)) {
+        cv::Mat rgbMat;
+        getRgbMat(img, rgbMat, sourceColorOrder);
+        copyFrom(rgbMat, qImgFormat);
+        return;
+    }
+
+    const bool swapRedBlue = sourceColorOrder == MatColorOrder::BGR && img.type() == CV_8UC3;
+
+    // Swapping in place would rewrite the pixels of the other Mats sharing the buffer
+    if (swapRedBlue && !isExclusivelyOwned(img)) {
+        cv::Mat rgbMat;
+        getRgbMat(img, rgbMat, sourceColorOrder);
+
+        if (isAdoptable(rgbMat)) {
+            adoptMat(std::move(rgbMat), qImgFormat);
+        } else {
+            copyFrom(rgbMat, qImgFormat);
+        }
+
+        return;
+    }
+
+    if (swapRedBlue && mBindingMode == BindingMode::Eager) {
+        QCVIMG_STATS_TIMER(Swizzle);
+        QCVimgSwizzle::swapRedBlue(img, img);
+        QCVIMG_STATS_RECORD(Swizzle, img.total() * img.elemSize());
+    }
+
+    adoptMat(std::move(img), qImgFormat);
+    mPendingRedBlueSwap = swapRedBlue && mBindingMode == BindingMode::Lazy && !mQImg.isNull();
+}
+
+QCVimgCore::QCVimgCore(const cv::Mat& img, QImage::Format format)
+{
+    if (!img.empty() && img.dims == 2 && convertQImgFormatTag(format) == img.type()) {
+        copyFrom(img, format);
+    }
+}
+
+QCVimgCore::QCVimgCore(cv::Mat&& img, QImage::Format format)
+{
+    if (img.empty() || img.dims != 2 || convertQImgFormatTag(format) != img.type()) {
+        return;
+    }
+
+    if (isAdoptable(img)) {
+        adoptMat(std::move(img), format);
+    } else {
+        copyFrom(img, format);
+    }
+}
+
+qsizetype QCVimgCore::bytes() const
+{
+    return mQImg.sizeInBytes();
+}
+
+QCVimgCore QCVimgCore::convertToFormat(QImage::Format format) const
+{
+    if (!isValidQImgFormat(format)) {
+        return QCVimgCore();
+    }
+
+    QCVIMG_STATS_TIMER(Conversion);
+    QCVIMG_STATS_RECORD(Conversion, mQImg.sizeInBytes());
+    auto kernel = findConversionKernel(mQImg.format(), format);
+
+    if (kernel != nullptr && !mQImg.isNull() && isDeviceResident()) {
+        QCVimgCore convertedImg(mQImg.width(), mQImg.height(), format);
+        kernel(mUMat, convertedImg.deviceTarget());
+        return convertedImg;
+    } else if (kernel != nullptr && !mQImg.isNull() && isMatBound()) {
+        QCVimgCore convertedImg(mQImg.width(), mQImg.height(), format);
+        syncToHost();
+        runConversionKernel(kernel, mMImg, convertedImg.mMImg);
+        return convertedImg;
+    } else {
+        return QCVimgCore(syncToHost().convertToFormat(format));
+    }
+}
+
+QFuture<QCVimgConstRef> QCVimgCore::convertToFormatAsync(QImage::Format format, QThreadPool* pool) const
+{
+    const QCVimgConstRef source = share();
+    const QCVimgExecution execution = QCVimgExecution::current();
+
+    return QtConcurrent::run(pool != nullptr ? pool : QThreadPool::globalInstance(), [source, format, execution] {
+        QCVimgExecution::Scope scope(execution);
+        return fromShared(source).convertToFormat(format).share();
+    });
+}
+
+int QCVimgCore::convertInto(QCVimgCore& dest, QImage::Format format) const
+{
+    if (&dest == this || !isValidQImgFormat(format) || mQImg.isNull() || !isMatBound()) {
+        return -1;
+    }
+
+    QCVIMG_STATS_TIMER(Conversion);
+
+    if (dest.mQImg.size() != mQImg.size() || dest.mQImg.format() != format ||
+        !dest.mQImg.isDetached() || !dest.isMatBound())
+    {
+        dest.mQImg = QImage(mQImg.size(), format);
+        createMatFromQImage(dest.mQImg, dest.mMImg);
+        QCVIMG_STATS_RECORD(Allocation, dest.mQImg.sizeInBytes());
+    }
+
+    QCVIMG_STATS_RECORD(Conversion, mQImg.sizeInBytes());
+    auto kernel = findConversionKernel(mQImg.format(), format);
+
+    if (kernel != nullptr && isDeviceResident()) {
+        kernel(mUMat, dest.deviceTarget());
+        return 0;
+    }
+
+    syncToHost();
+
+    if (kernel != nullptr) {
+        runConversionKernel(kernel, mMImg, dest.mMImg);
+    } else if (mQImg.format() == format) {
+        mMImg.copyTo(dest.mMImg);
+    } else {
+        const QImage convertedQImg = mQImg.convertToFormat(format);
+        cv::Mat convertedMat(convertedQImg.height(),
+                             convertedQImg.width(),
+                             dest.mMImg.type(),
+                             const_cast<uchar*>(convertedQImg.constBits()),
+                             static_cast<unsigned long>(convertedQImg.bytesPerLine()));
+        convertedMat.copyTo(dest.mMImg);
+    }
+
+    dest.invalidateCaches();
+    return 0;
+}
+
+int QCVimgCore::convertTo(QImage::Format format, Qt::ImageConversionFlags flags)
+{
+    if (mQImg.isNull() || !isValidQImgFormat(format)) {
+        return -1;
+    }
+
+    if (mQImg.format() != format) {
+        QCVIMG_STATS_TIMER(Conversion);
+        QCVIMG_STATS_RECORD(Conversion, mQImg.sizeInBytes());
+        syncToHost();
+        mQImg.convertTo(format, flags);
+        createMatFromQImage(mQImg, mMImg);
+        invalidateCaches();
+    }
+
+    return 0;
+}
+
+int QCVimgCore::copy(const QImage& sourceQImg)
+{
+    if (isValidQImgFormat(sourceQImg.format())) {
+        copyFrom(sourceQImg);
+        return 0;
+    } else {
+        return -1;
+    }
+}
+
+int QCVimgCore::copy(const cv::Mat& sourceMat, MatColorOrder sourceColorOrder)
+{
+    auto qImgFormat = convertMatFormatTag(sourceMat.type());
+
+    cv::Mat rgbMat;
+    getRgbMat(sourceMat, rgbMat, sourceColorOrder);
+
+    if (sizesMatch(rgbMat, mMImg) && typesMatch(rgbMat, mMImg)) {
+        detach();
+        rgbMat.copyTo(mMImg);
+        invalidateCaches();
+        recordDeepCopy(mQImg.sizeInBytes());
+        return 0;
+    } else if (qImgFormat != QImage::Format_Invalid) {
+        copyFrom(rgbMat, qImgFormat);
+        return 0;
+    } else {
+        return -1;
+    }
+
+}
+
+void QCVimgCore::copyTo(cv::OutputArray dest) const
+{
+    QCVIMG_STATS_TIMER(DeepCopy);
+    syncToHost();
+    mMImg.copyTo(dest);
+    QCVIMG_STATS_RECORD(DeepCopy, mMImg.total() * mMImg.elemSize());
+}
+
+void QCVimgCore::copyTo(QImage& dest) const
+{
+    QCVIMG_STATS_TIMER(DeepCopy);
+    dest = syncToHost().copy();
+    QCVIMG_STATS_RECORD(Allocation, dest.sizeInBytes());
+    QCVIMG_STATS_RECORD(DeepCopy, dest.sizeInBytes());
+}
+
+int QCVimgCore::upload()
+{
+    if (mQImg.isNull() || !isMatBound()) {
+        return -1;
+    }
+
+    if (!isDeviceResident()) {
+        QCVIMG_STATS_TIMER(DeepCopy);
+        syncToHost();
+        mMImg.copyTo(mUMat);
+        QCVIMG_STATS_RECORD(DeepCopy, mQImg.sizeInBytes());
+    }
+
+    return 0;
+}
+
+int QCVimgCore::download()
+{
+    if (!isDeviceResident()) {
+        return -1;
+    }
+
+    syncToHost();
+    return 0;
+}
+
+void QCVimgCore::releaseDevice()
+{
+    syncToHost();
+    mUMat.release();
+}
+
+bool QCVimgCore::isDeviceResident() const
+{
+    return !mUMat.empty();
+}
+
+cv::UMat& QCVimgCore::uMat()
+{
+    if (upload() != 0) {
+        return mUMat;
+    }
+
+    return deviceTarget();
+}
+
+const cv::UMat& QCVimgCore::uMat() const
+{
+    if (!isDeviceResident() && !mQImg.isNull() && isMatBound()) {
+        syncToHost();
+        mMImg.copyTo(mUMat);
+    }
+
+    return mUMat;
+}
+
+cv::Mat& QCVimgCore::cvMat()
+{
+    detach();
+    // The caller may write through the reference, so anything derived from the data is stale
+    ++mGeneration;
+    mHashCached = false;
+
+    return mMImg;
+}
+
+const cv::Mat& QCVimgCore::cvMat() const
+{
+    syncToHost();
+
+    return mMImg;
+}
+
+bool QCVimgCore::detach()
+{
+    syncToHost();
+    const uchar* dataBeforeDetach = mQImg.constBits();
+
+    // The host data is about to be modified, so the device copy becomes stale.
+    // All other caches are invalidated by the writes themselves (or #markDirty).
+    mUMat.release();
+
+    // bits() detaches both shared and read-only external data
+    if (mQImg.bits() == dataBeforeDetach) {
+        return false;
+    }
+
+    recordDetach(mQImg.sizeInBytes());
+
+    // A Mat deliberately pointing elsewhere (e.g. before rebindQImg) is left alone
+    if (mMImg.data == dataBeforeDetach) {
+        createMatFromQImage(mQImg, mMImg);
+    }
+
+    return true;
+}
+
+bool QCVimgCore::empty() const
+{
+    return mQImg.isNull() && matIsNull();
+}
+
+void QCVimgCore::fill(uint pixelValue)
+{
+    QImage pixelQImg(1, 1, mQImg.format());
+    pixelQImg.fill(pixelValue);
+    fillWithPixel(pixelQImg, mQImg.rect());
+}
+
+void QCVimgCore::fill(const QColor& color)
+{
+    fill(color, mQImg.rect());
+}
+
+void QCVimgCore::fill(const Qt::GlobalColor color)
+{
+    fill(QColor(color), mQImg.rect());
+}
+
+void QCVimgCore::fill(const QColor& color, const QRect& rect)
+{
+    QImage pixelQImg(1, 1, mQImg.format());
+    pixelQImg.fill(color);
+    fillWithPixel(pixelQImg, rect);
+}
+
+int QCVimgCore::fill(const cv::Scalar& value, MatColorOrder valueColorOrder, const QRect& rect)
+{
+    if (mQImg.isNull() || !isMatBound()) {
+        return -1;
+    }
+
+    const QRect fillRect = rect.isNull() ? mQImg.rect() : rect & mQImg.rect();
+
+    if (fillRect.isEmpty()) {
+        return 0;
+    }
+
+    // RGB32 and ARGB32 store the channels in BGRA order, BGR888 in BGR, the other color formats in RGB(A) order
+    const bool storedAsBgr = isStoredAsBgr(mQImg.format());
+    cv::Scalar pixelValue = value;
+
+    if (mMImg.channels() >= 3 && storedAsBgr != (valueColorOrder == MatColorOrder::BGR)) {
+        std::swap(pixelValue[0], pixelValue[2]);
+    }
+
+    detachRegion(fillRect);
+    cv::Mat fillMat = mMImg(cv::Rect(fillRect.x(), fillRect.y(), fillRect.width(), fillRect.height()));
+
+    return QCVimgFill::fill(fillMat, pixelValue);
+}
+
+size_t QCVimgCore::hash(HashCaching caching) const
+{
+    if (caching == HashCaching::Enabled && mHashCached) {
+        return mCachedHash;
+    }
+
+    const size_t dataHash = hashImageData(syncToHost());
+
+    if (caching == HashCaching::Enabled) {
+        mCachedHash = dataHash;
+        mHashCached = true;
+    }
+
+    return dataHash;
+}
+
+int QCVimgCore::height() const
+{
+    return mQImg.height();
+}
+
+bool QCVimgCore::isMatBound() const
+{
+     return pointersMatch() && sizesMatch() && formatsMatch();
+}
+
+int QCVimgCore::load(const QString& fileName, const char* format)
+{
+    QCVimgReader reader(fileName, QByteArray(format));
+
+    return reader.read(*this);
+}
+
+uchar* QCVimgCore::mutableBits()
+{
+    detach();
+    invalidateCaches();
+
+    return mQImg.bits();
+}
+
+int QCVimgCore::matFormat() const
+{
+    return mMImg.type();
+}
+
+QImage::Format QCVimgCore::qFormat() const
+{
+    return mQImg.format();
+}
+
+bool QCVimgCore::operator==(const QCVimgCore& other) const
+{
+    if (isMatBound() != other.isMatBound()) {
+        return false;
+    }
+
+    return imageDataEqual(syncToHost(), other.syncToHost());
+}
+
+bool QCVimgCore::operator!=(const QCVimgCore& other) const
+{
+    return !(*this == other);
+}
+
+QImage& QCVimgCore::qImg()
+{
+    detach();
+    // The caller may write through the reference, so anything derived from the data is stale
+    ++mGeneration;
+    mHashCached = false;
+
+    return mQImg;
+}
+
+const QImage& QCVimgCore::qImg() const
+{
+    return syncToHost();
+}
+
+QPixmap QCVimgCore::qPix(Qt::ImageConversionFlags flags) const &
+{
+    if (mCachedPix.isNull() || mCachedPixGeneration != mGeneration || mCachedPixFlags != flags) {
+        QCVIMG_STATS_TIMER(Conversion);
+        mCachedPix = QPixmap::fromImage(syncToHost(), flags);
+        mCachedPixGeneration = mGeneration;
+        mCachedPixFlags = flags;
+        QCVIMG_STATS_RECORD(Conversion, mQImg.sizeInBytes());
+    }
+
+    return mCachedPix;
+}
+
+QPixmap QCVimgCore::qPix(Qt::ImageConversionFlags flags) &&
+{
+    syncToHost();
+    QCVIMG_STATS_TIMER(Conversion);
+    QCVIMG_STATS_RECORD(Conversion, mQImg.sizeInBytes());
+    QPixmap pixmap = QPixmap::fromImage(std::move(mQImg), flags);
+    setMembersEmpty();
+
+    return pixmap;
+}
+
+quint64 QCVimgCore::generation() const
+{
+    return mGeneration;
+}
+
+QRegion QCVimgCore::qPixUpdate(QPixmap& pixmap, Qt::ImageConversionFlags flags)
+{
+    const QImage& hostQImg = syncToHost();
+    QRegion updatedRegion;
+
+    if (pixmap.size() != hostQImg.size()) {
+        pixmap = QPixmap::fromImage(hostQImg, flags);
+        updatedRegion = hostQImg.rect();
+    } else if (!mDirtyRegion.isEmpty()) {
+        QPainter painter(&pixmap);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+
+        for (const QRect& rect : mDirtyRegion) {
+            painter.drawImage(rect.topLeft(), hostQImg, rect, flags);
+        }
+
+        updatedRegion = mDirtyRegion;
+    }
+
+    mDirtyRegion = QRegion();
+    return updatedRegion;
+}
+
+QRegion QCVimgCore::dirtyRegion() const
+{
+    return mDirtyRegion;
+}
+
+void QCVimgCore::markDirty(const QRect& rect)
+{
+    mDirtyRegion += rect & mQImg.rect();
+    ++mGeneration;
+    mHashCached = false;
+    mUMat.release();
+}
+
+void QCVimgCore::markDirty()
+{
+    markDirty(mQImg.rect());
+}
+
+void QCVimgCore::clearDirty()
+{
+    mDirtyRegion = QRegion();
+}
+
+QColor QCVimgCore::pixelColor(int x, int y) const
+{
+    return syncToHost().pixelColor(x, y);
+}
+
+int QCVimgCore::rebindMat(DataPrio priority)
+{
+    bool qImgFormatValid = isValidQImgFormat(mQImg.format());
+
+    if (!qImgFormatValid && priority == DataPrio::Low) {
+        setMembersEmpty();
+        return -1;
+    } else if (!qImgFormatValid && priority == DataPrio::Hi) {
+        mMImg = cv::Mat();
+        return -1;
+    } else {
+        QCVIMG_STATS_TIMER(Rebind);
+        syncToHost();
+        createMatFromQImage(mQImg, mMImg);
+        invalidateCaches();
+        QCVIMG_STATS_RECORD(Rebind, mQImg.sizeInBytes());
+        return 0;
+    }
+}
+
+int QCVimgCore::rebindQImg(DataPrio priority, MatColorOrder matColorOrder)
+{
+    QImage::Format qImgFormat = convertMatFormatTag(mMImg.type());
+    bool matFormatValid = !(qImgFormat == QImage::Format_Invalid);
+
+    if (!matFormatValid && priority == DataPrio::Low) {
+        setMembersEmpty();
+        return -1;
+    } else if (!matFormatValid && priority == DataPrio::Hi) {
+        mQImg = QImage();
+        invalidateCaches();
+        return -1;
+    }
+
+    QCVIMG_STATS_TIMER(Rebind);
+    syncToHost();
+    const bool swapRedBlue = matColorOrder == MatColorOrder::BGR && mMImg.type() == CV_8UC3;
+
+    if (isExclusivelyOwned(mMImg)) {
+        // Nothing else can see the buffer, so it can become the QImage data as is
+        adoptMat(std::move(mMImg), qImgFormat);
+        invalidateCaches();
+        mPendingRedBlueSwap = swapRedBlue;
+    } else if (mBindingMode == BindingMode::Lazy) {
+        cv::Mat sourceMat = mMImg;
+        createQImageFromMat(sourceMat, mQImg, qImgFormat);
+        createMatFromQImage(mQImg, mMImg);
+        invalidateCaches();
+        mPendingMat = sourceMat;
+        mPendingRedBlueSwap = swapRedBlue;
+    } else {
+        cv::Mat rgbMat;
+        getRgbMat(mMImg, rgbMat, matColorOrder);
+        copyFrom(rgbMat, qImgFormat);
+    }
+
+    if (mBindingMode == BindingMode::Eager) {
+        bindPendingData();
+    }
+
+    QCVIMG_STATS_RECORD(Rebind, mQImg.sizeInBytes());
+    return 0;
+}
+
+void QCVimgCore::setBindingMode(BindingMode mode)
+{
+    mBindingMode = mode;
+
+    if (mode == BindingMode::Eager) {
+        syncToHost();
+    }
+}
+
+BindingMode QCVimgCore::bindingMode() const
+{
+    return mBindingMode;
+}
+
+QCVimgCore QCVimgCore::resize(int width, int height, Qt::AspectRatioMode aspectRatioMode, Qt::TransformationMode transformMode) const
+{
+    return QCVimgCore(syncToHost().scaled(width, height, aspectRatioMode, transformMode));
+}
+
+QCVimgCore QCVimgCore::resize(int width, int height, ResizeInterpolation interpolation, Qt::AspectRatioMode aspectRatioMode) const
+{
+    QCVimgCore resizedImg;
+    resizeInto(resizedImg, width, height, interpolation, aspectRatioMode);
+
+    return resizedImg;
+}
+
+QFuture<QCVimgConstRef> QCVimgCore::resizeAsync(int width, int height, ResizeInterpolation interpolation,
+                                                Qt::AspectRatioMode aspectRatioMode, QThreadPool* pool) const
+{
+    const QCVimgConstRef source = share();
+    const QCVimgExecution execution = QCVimgExecution::current();
+
+    return QtConcurrent::run(pool != nullptr ? pool : QThreadPool::globalInstance(),
+                             [source, width, height, interpolation, aspectRatioMode, execution] {
+        QCVimgExecution::Scope scope(execution);
+        return fromShared(source).resize(width, height, interpolation, aspectRatioMode).share();
+    });
+}
+
+int QCVimgCore::resizeInto(QCVimgCore& dest, int width, int height, ResizeInterpolation interpolation, Qt::AspectRatioMode aspectRatioMode) const
+{
+    const QSize destSize = mQImg.size().scaled(width, height, aspectRatioMode);
+
+    if (&dest == this || mQImg.isNull() || !isMatBound() || destSize.isEmpty()) {
+        return -1;
+    }
+
+    if (dest.mQImg.size() != destSize || dest.mQImg.format() != mQImg.format() ||
+        !dest.mQImg.isDetached() || !dest.isMatBound())
+    {
+        dest.mQImg = QImage(destSize, mQImg.format());
+        createMatFromQImage(dest.mQImg, dest.mMImg);
+        QCVIMG_STATS_RECORD(Allocation, dest.mQImg.sizeInBytes());
+    }
+
+    if (isDeviceResident()) {
+        cv::resize(mUMat, dest.deviceTarget(), dest.mMImg.size(), 0, 0, convertInterpolation(interpolation));
+        return 0;
+    }
+
+    syncToHost();
+    cv::resize(mMImg, dest.mMImg, dest.mMImg.size(), 0, 0, convertInterpolation(interpolation));
+    dest.invalidateCaches();
+
+    return 0;
+}
+
+QCVimgPyramid QCVimgCore::pyramid(int levels, PyramidFilter filter) const
+{
+    return QCVimgPyramid(*this, levels, filter);
+}
+
+QCVimgConstRef QCVimgCore::share() const
+{
+    if (mQImg.isNull() || !isMatBound()) {
+        return QCVimgConstRef();
+    }
+
+    return QCVimgConstRef(syncToHost(), mMImg.type());
+}
+
+int QCVimgCore::save(const QString& fileName, const char* format, int quality) const
+{
+    return syncToHost().save(fileName, format, quality) ? 0 : -1;
+}
+
+bool QCVimgCore::shared() const
+{
+    return !mQImg.isNull() && !mQImg.isDetached();
+}
+
+void QCVimgCore::swap(QCVimgCore &other)
+{
+    mQImg.swap(other.mQImg);
+    cv::swap(mMImg, other.mMImg);
+    cv::swap(mUMat, other.mUMat);
+    std::swap(mCachedHash, other.mCachedHash);
+    std::swap(mHashCached, other.mHashCached);
+    std::swap(mDeviceDirty, other.mDeviceDirty);
+    cv::swap(mPendingMat, other.mPendingMat);
+    std::swap(mPendingRedBlueSwap, other.mPendingRedBlueSwap);
+    std::swap(mBindingMode, other.mBindingMode);
+    mDirtyRegion.swap(other.mDirtyRegion);
+    // Both images changed, and generations must not go back
+    mGeneration = other.mGeneration = std::max(mGeneration, other.mGeneration) + 1;
+    mCachedPix = QPixmap();
+    other.mCachedPix = QPixmap();
+}
+
+bool QCVimgCore::valid(int x, int y) const
+{
+    return mQImg.valid(x, y);
+}
+
+QCVimgView QCVimgCore::view(const QRect& rect)
+{
+    const QRect viewRect = rect & mQImg.rect();
+
+    if (viewRect.isEmpty() || !isValidQImgFormat(mQImg.format())) {
+        return QCVimgView();
+    }
+
+    detachRegion(viewRect);
+
+    const int bytesPerLine = mQImg.bytesPerLine();
+    uchar* viewData = mQImg.bits()
+            + static_cast<qsizetype>(viewRect.y()) * bytesPerLine
+            + static_cast<qsizetype>(viewRect.x()) * (mQImg.depth() / 8);
+
+    return QCVimgView(viewData, viewRect, bytesPerLine, mQImg.format(),
+                      convertQImgFormatTag(mQImg.format()));
+}
+
+int QCVimgCore::width() const
+{
+    return mQImg.width();
+}
+
+int QCVimgCore::writeTo(QDataStream& ds, StreamEncoding encoding) const
+{
+    syncToHost();
+
+    if (encoding == StreamEncoding::Raw) {
+        writeRawTo(ds);
+    } else {
+        ds << mQImg.format()
+           << mMImg.rows
+           << mMImg.cols
+           << mMImg.type()
+           << mQImg;
+    }
+
+    return ds.status() == QDataStream::Ok ? 0 : -1;
+}
+
+QCVimgCore::CopyStats QCVimgCore::copyStats()
+{
+    CopyStats stats;
+    stats.detaches = sDetachCount.load(std::memory_order_relaxed);
+    stats.deepCopies = sDeepCopyCount.load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+void QCVimgCore::resetCopyStats()
+{
+    sDetachCount.store(0, std::memory_order_relaxed);
+    sDeepCopyCount.store(0, std::memory_order_relaxed);
+}
+
+QCVimgStats::Snapshot QCVimgCore::stats()
+{
+    return QCVimgStats::snapshot();
+}
+
+QCVimgCore QCVimgCore::mapFile(const QString& fileName, QIODevice::OpenMode mode)
+{
+    const bool writeBack = mode.testFlag(QIODevice::WriteOnly);
+    auto file = new QFile(fileName);
+
+    if (!file->open(writeBack ? QIODevice::ReadWrite : QIODevice::ReadOnly)) {
+        delete file;
+        return QCVimgCore();
+    }
+
+    // Private mappings are copy-on-write, so the image stays writable without modifying the file
+    uchar* data = file->map(0, file->size(), writeBack ? QFileDevice::NoOptions : QFileDevice::MapPrivateOption);
+
+    if (data == nullptr) {
+        delete file;
+        return QCVimgCore();
+    }
+
+    return fromRawData(data, file->size(), releaseMappedFile, file);
+}
+
+QCVimgCore QCVimgCore::fromSharedMemory(QSharedMemory& sharedMemory)
+{
+    if (!sharedMemory.isAttached()) {
+        return QCVimgCore();
+    }
+
+    return fromRawData(static_cast<uchar*>(sharedMemory.data()), sharedMemory.size(), nullptr, nullptr);
+}
+
+QCVimgCore QCVimgCore::fromSharedMemory(QSharedMemory& sharedMemory, int width, int height, QImage::Format format)
+{
+    const qsizetype requiredSize = rawSize(width, height, format);
+
+    if (!sharedMemory.isAttached() || requiredSize < 0 || sharedMemory.size() < requiredSize) {
+        return QCVimgCore();
+    }
+
+    QByteArray headerBytes;
+    QDataStream headerStream(&headerBytes, QIODevice::WriteOnly);
+    writeRawHeader(headerStream, format, height, width, static_cast<int>(rawBytesPerLine(width, format)));
+    std::memcpy(sharedMemory.data(), headerBytes.constData(), static_cast<size_t>(headerBytes.size()));
+
+    return fromRawData(static_cast<uchar*>(sharedMemory.data()), sharedMemory.size(), nullptr, nullptr);
+}
+
+qsizetype QCVimgCore::rawSize(int width, int height, QImage::Format format)
+{
+    if (!isValidQImgFormat(format) || width <= 0 || height <= 0) {
+        return -1;
+    }
+
+    return scmStreamHeaderSize + rawBytesPerLine(width, format) * height;
+}
+
+int QCVimgCore::swapMatRedBlue(const cv::Mat& sourceMat, cv::Mat& destMat, MatColorOrder sourceMatColorOrder)
+{
+    // Swapping red and blue is symmetric, so the source color order doesn't change the result
+    Q_UNUSED(sourceMatColorOrder)
+
+    QCVIMG_STATS_TIMER(Swizzle);
+    QCVIMG_STATS_RECORD(Swizzle, sourceMat.total() * sourceMat.elemSize());
+    return QCVimgSwizzle::swapRedBlue(sourceMat, destMat);
+}
+
+cv::Scalar QCVimgCore::convertQColorToScalar(const QColor& color, MatColorOrder destScalarColorOrder)
+{
+    int red = color.red();
+    int green = color.green();
+    int blue = color.blue();
+
+    if (destScalarColorOrder == MatColorOrder::RGB) {
+        return cv::Scalar_<int>(red, green, blue);
+    } else {
+        return cv::Scalar_<int>(blue, green, red);
+    }
+}
+
+QStringList QCVimgCore::supportedQImgFormats()
+{
+    return scmTextToQImgFormat.uniqueKeys();
+}
+
+QImage::Format QCVimgCore::convertFormatTextToQImgFormat(const QString &formatText)
+{
+    auto it = scmTextToQImgFormat.find(formatText);
+
+    if (it == scmTextToQImgFormat.end()) {
+        return QImage::Format_Invalid;
+    } else {
+        return *it;
+    }
+}
+
+QMap<QString, QImage::Format> QCVimgCore::fillQImgFormatToStringMap()
+{
+    return
+    {
+        {"Alpha 8 bit", QImage::Format_Alpha8},
+        {"ARGB 32 bit", QImage::Format_ARGB32},
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        {"BGR 24 bit", QImage::Format_BGR888},
+#endif
+        {"Grayscale 8 bit", QImage::Format_Grayscale8},
+        {"Grayscale 16 bit", QImage::Format_Grayscale16},
+        {"RGB 32 bit", QImage::Format_RGB32},
+        {"RGB 24 bit", QImage::Format_RGB888},
+        {"RGBA 32 bit", QImage::Format_RGBA8888},
+        {"RGBA 64 bit", QImage::Format_RGBA64},
+        {"RGBX 32 bit", QImage::Format_RGBX8888},
+        {"RGBX 64 bit", QImage::Format_RGBX64}
+    };
+}
+
+void QCVimgCore::createMatFromQImage(QImage& sourceQImg, cv::Mat& targetMat) const
+{
+    targetMat = cv::Mat(sourceQImg.height(),
+                sourceQImg.width(),
+                convertQImgFormatTag(sourceQImg.format()),
+                sourceQImg.bits(),
+                static_cast<unsigned long>(sourceQImg.bytesPerLine()));
+}
+
+void QCVimgCore::createQImageFromMat(const cv::Mat& sourceMat, QImage& targetQImg, QImage::Format qFormat) const
+{
+    targetQImg = QImage(sourceMat.cols, sourceMat.rows, qFormat);
+    QCVIMG_STATS_RECORD(Allocation, targetQImg.sizeInBytes());
+}
+
+void QCVimgCore::copyFrom(const cv::Mat& sourceMat, QImage::Format qFormat)
+{
+    QCVIMG_STATS_TIMER(DeepCopy);
+    createQImageFromMat(sourceMat, mQImg, qFormat);
+    createMatFromQImage(mQImg, mMImg);
+    sourceMat.copyTo(mMImg);
+    invalidateCaches();
+    recordDeepCopy(mQImg.sizeInBytes());
+}
+
+void QCVimgCore::copyFrom(const QImage& sourceQImg)
+{
+    QCVIMG_STATS_TIMER(DeepCopy);
+    mQImg = sourceQImg.copy();
+    createMatFromQImage(mQImg, mMImg);
+    invalidateCaches();
+    QCVIMG_STATS_RECORD(Allocation, mQImg.sizeInBytes());
+    recordDeepCopy(mQImg.sizeInBytes());
+}
+
+void QCVimgCore::getRgbMat(const cv::Mat& sourceMat, cv::Mat& rgbMat, MatColorOrder sourceColorOrder) const
+{
+    if (sourceColorOrder == MatColorOrder::BGR && sourceMat.type() == CV_8UC3) {
+        QCVIMG_STATS_TIMER(Swizzle);
+        rgbMat = cv::Mat();
+        QCVimgSwizzle::swapRedBlue(sourceMat, rgbMat);
+        QCVIMG_STATS_RECORD(Allocation, rgbMat.total() * rgbMat.elemSize());
+        QCVIMG_STATS_RECORD(Swizzle, rgbMat.total() * rgbMat.elemSize());
+    } else {
+        rgbMat = sourceMat;
+    }
+}
+
+int QCVimgCore::convertInterpolation(ResizeInterpolation interpolation)
+{
+    switch (interpolation) {
+    case ResizeInterpolation::Nearest:
+        return cv::INTER_NEAREST;
+    case ResizeInterpolation::Linear:
+        return cv::INTER_LINEAR;
+    case ResizeInterpolation::Cubic:
+        return cv::INTER_CUBIC;
+    case ResizeInterpolation::Area:
+    default:
+        return cv::INTER_AREA;
+    }
+}
+
+bool QCVimgCore::isAdoptable(const cv::Mat& sourceMat)
+{
+    // Mats created on top of external data have no allocator info attached to
+    // them, and QImage requires 32 bit aligned scanlines
+    return !sourceMat.empty() && sourceMat.dims == 2 && sourceMat.u != nullptr && sourceMat.step[0] % 4 == 0 &&
+           reinterpret_cast<quintptr>(sourceMat.data) % 4 == 0;
+}
+
+bool QCVimgCore::isExclusivelyOwned(const cv::Mat& sourceMat)
+{
+    // No other Mat (or UMat) header references the buffer, and the header
+    // starts at the beginning of it
+    return isAdoptable(sourceMat) && sourceMat.u->refcount == 1 && sourceMat.u->urefcount == 0 &&
+           sourceMat.data == sourceMat.u->data && sourceMat.isContinuous();
+}
+
+void QCVimgCore::adoptMat(cv::Mat&& sourceMat, QImage::Format qFormat)
+{
+    auto adoptedMat = new cv::Mat(std::move(sourceMat));
+
+    mQImg = QImage(adoptedMat->data,
+                   adoptedMat->cols,
+                   adoptedMat->rows,
+                   static_cast<int>(adoptedMat->step[0]),
+                   qFormat,
+                   releaseAdoptedMat,
+                   adoptedMat);
+
+    if (mQImg.isNull()) {
+        // QImage doesn't call the cleanup function if it couldn't be created
+        delete adoptedMat;
+    } else {
+        createMatFromQImage(mQImg, mMImg);
+    }
+}
+
+void QCVimgCore::releaseAdoptedMat(void* adoptedMat)
+{
+    delete static_cast<cv::Mat*>(adoptedMat);
+}
+
+void QCVimgCore::writeRawTo(QDataStream& ds) const
+{
+    const int bytesPerLine = mQImg.bytesPerLine();
+
+    writeRawHeader(ds, mQImg.format(), mQImg.height(), mQImg.width(), bytesPerLine);
+
+    if (mQImg.isNull()) {
+        return;
+    }
+
+    if (mQImg.sizeInBytes() <= std::numeric_limits<int>::max()) {
+        ds.writeRawData(reinterpret_cast<const char*>(mQImg.constBits()), static_cast<int>(mQImg.sizeInBytes()));
+    } else {
+        for (int row = 0; row < mQImg.height(); ++row) {
+            ds.writeRawData(reinterpret_cast<const char*>(mQImg.constScanLine(row)), bytesPerLine);
+        }
+    }
+}
+
+void QCVimgCore::readRawFrom(QDataStream& ds)
+{
+    RawHeader header;
+
+    if (readRawHeader(ds, header) != 0 || header.rows == 0) {
+        setMembersEmpty();
+        return;
+    }
+
+    // The existing buffer is reused when possible, so repeatedly reading frames doesn't allocate
+    if (mQImg.width() != header.cols || mQImg.height() != header.rows ||
+        mQImg.format() != header.format || !mQImg.isDetached())
+    {
+        mQImg = QImage(header.cols, header.rows, header.format);
+        QCVIMG_STATS_RECORD(Allocation, mQImg.sizeInBytes());
+    }
+
+    if (mQImg.isNull()) {
+        setMembersEmpty();
+        ds.setStatus(QDataStream::ReadCorruptData);
+        return;
+    }
+
+    if (header.stride == mQImg.bytesPerLine() && mQImg.sizeInBytes() <= std::numeric_limits<int>::max()) {
+        ds.readRawData(reinterpret_cast<char*>(mQImg.bits()), static_cast<int>(mQImg.sizeInBytes()));
+    } else {
+        for (int row = 0; row < header.rows && ds.status() == QDataStream::Ok; ++row) {
+            ds.readRawData(reinterpret_cast<char*>(mQImg.scanLine(row)), header.lineBytes);
+            ds.skipRawData(header.stride - header.lineBytes);
+        }
+    }
+
+    if (ds.status() != QDataStream::Ok) {
+        setMembersEmpty();
+        return;
+    }
+
+    createMatFromQImage(mQImg, mMImg);
+    invalidateCaches();
+}
+
+void QCVimgCore::writeRawHeader(QDataStream& ds, QImage::Format format, int rows, int cols, int stride)
+{
+    ds << scmStreamMagic
+       << scmStreamVersion
+       << scmStreamHeaderSize
+       << static_cast<qint32>(format)
+       << static_cast<qint32>(rows)
+       << static_cast<qint32>(cols)
+       << static_cast<qint32>(convertQImgFormatTag(format))
+       << static_cast<qint32>(stride);
+
+    // Padding keeps the scanlines aligned in memory mapped data
+    const char padding[scmStreamHeaderSize - scRawHeaderFieldBytes] = {};
+    ds.writeRawData(padding, sizeof(padding));
+}
+
+int QCVimgCore::readRawHeader(QDataStream& ds, RawHeader& header)
+{
+    quint16 version = 0, headerSize = 0;
+    qint32 qFormat = 0, rows = 0, cols = 0, matType = -1, stride = 0;
+
+    ds >> version
+       >> headerSize
+       >> qFormat
+       >> rows
+       >> cols
+       >> matType
+       >> stride;
+
+    if (ds.status() == QDataStream::Ok && headerSize >= scRawHeaderFieldBytes) {
+        ds.skipRawData(headerSize - scRawHeaderFieldBytes);
+    }
+
+    header.format = static_cast<QImage::Format>(qFormat);
+    header.rows = rows;
+    header.cols = cols;
+    header.stride = stride;
+    header.headerSize = headerSize;
+
+    const bool isEmpty = rows == 0 && cols == 0;
+    const bool isValidFormat = isValidQImgFormat(header.format) && convertQImgFormatTag(header.format) == matType;
+    const qint64 lineBytes = isValidFormat ?
+                (static_cast<qint64>(cols) * QImage::toPixelFormat(header.format).bitsPerPixel() + 7) / 8 : 0;
+
+    if (ds.status() != QDataStream::Ok || version > scmStreamVersion || headerSize < scRawHeaderFieldBytes ||
+        (!isEmpty && (rows <= 0 || cols <= 0 || !isValidFormat || stride < lineBytes)))
+    {
+        ds.setStatus(QDataStream::ReadCorruptData);
+        return -1;
+    }
+
+    header.lineBytes = static_cast<int>(lineBytes);
+
+    return 0;
+}
+
+QCVimgCore QCVimgCore::fromRawData(uchar* data, qint64 size, QImageCleanupFunction cleanupFunction, void* cleanupInfo)
+{
+    const int headerBytes = static_cast<int>(qMin<qint64>(size, std::numeric_limits<quint16>::max()));
+    const QByteArray header = QByteArray::fromRawData(reinterpret_cast<const char*>(data), headerBytes);
+    QDataStream headerStream(header);
+    qint32 magic = 0;
+    RawHeader rawHeader;
+    QImage mappedQImg;
+
+    headerStream >> magic;
+
+    if (magic == scmStreamMagic && readRawHeader(headerStream, rawHeader) == 0 && rawHeader.rows > 0 &&
+        rawHeader.headerSize + static_cast<qint64>(rawHeader.stride) * rawHeader.rows <= size &&
+        rawHeader.stride % 4 == 0 && rawHeader.headerSize % 4 == 0)
+    {
+        mappedQImg = QImage(data + rawHeader.headerSize, rawHeader.cols, rawHeader.rows, rawHeader.stride,
+                            rawHeader.format, cleanupFunction, cleanupInfo);
+    }
+
+    // QImage doesn't call the cleanup function if it couldn't be created
+    if (mappedQImg.isNull()) {
+        if (cleanupFunction != nullptr) {
+            cleanupFunction(cleanupInfo);
+        }
+
+        return QCVimgCore();
+    }
+
+    return QCVimgCore(std::move(mappedQImg));
+}
+
+// The Mat points to the shared buffer, any modification detaches it first (see detach)
+QCVimgCore QCVimgCore::fromShared(const QCVimgConstRef& sharedImg)
+{
+    QCVimgCore img;
+    img.mQImg = sharedImg.mQImg;
+    img.mMImg = sharedImg.mMImg;
+
+    return img;
+}
+
+void QCVimgCore::releaseMappedFile(void* mappedFile)
+{
+    // Destroying the file also unmaps it
+    delete static_cast<QFile*>(mappedFile);
+}
+
+void QCVimgCore::fillWithPixel(const QImage& pixelQImg, const QRect& rect)
+{
+    const QRect fillRect = rect & mQImg.rect();
+
+    if (fillRect.isEmpty() || !isValidQImgFormat(mQImg.format())) {
+        return;
+    }
+
+    detachRegion(fillRect);
+
+    const int pixelBytes = mQImg.depth() / 8;
+    const qsizetype bytesPerLine = mQImg.bytesPerLine();
+    uchar* fillData = mQImg.bits()
+            + static_cast<qsizetype>(fillRect.y()) * bytesPerLine
+            + static_cast<qsizetype>(fillRect.x()) * pixelBytes;
+
+    QCVimgFill::fill(fillData, bytesPerLine, fillRect.height(), fillRect.width() * pixelBytes,
+                     pixelQImg.constBits(), pixelBytes);
+}
+
+void QCVimgCore::invalidateCaches()
+{
+    ++mGeneration;
+    mCachedPix = QPixmap();
+    mDirtyRegion = mQImg.rect();
+    mHashCached = false;
+    mUMat.release();
+    mDeviceDirty = false;
+    mPendingMat.release();
+    mPendingRedBlueSwap = false;
+}
+
+void QCVimgCore::detachRegion(const QRect& rect)
+{
+    // Detaching doesn't change the data, only the region written afterwards
+    // needs to be marked
+    const QRegion dirtyRegion = mDirtyRegion;
+    detach();
+    invalidateCaches();
+    mDirtyRegion = dirtyRegion + rect;
+}
+
+const QImage& QCVimgCore::syncToHost() const
+{
+    if (mDeviceDirty) {
+        // deviceTarget made the host buffer unique, so it can be written in place
+        cv::Mat hostMat = mMImg;
+        mUMat.copyTo(hostMat);
+        mDeviceDirty = false;
+        QCVIMG_STATS_RECORD(DeepCopy, mQImg.sizeInBytes());
+    }
+
+    if (mPendingRedBlueSwap || !mPendingMat.empty()) {
+        bindPendingData();
+    }
+
+    return mQImg;
+}
+
+void QCVimgCore::bindPendingData() const
+{
+    if (!mPendingRedBlueSwap && mPendingMat.empty()) {
+        return;
+    }
+
+    // The members are already bound with their final size and format, only
+    // the data is written, in place
+    const cv::Mat& sourceMat = mPendingMat.empty() ? mMImg : mPendingMat;
+    cv::Mat hostMat = mMImg;
+
+    if (mPendingRedBlueSwap) {
+        QCVIMG_STATS_TIMER(Swizzle);
+        QCVimgSwizzle::swapRedBlue(sourceMat, hostMat);
+        QCVIMG_STATS_RECORD(Swizzle, hostMat.total() * hostMat.elemSize());
+    } else {
+        QCVIMG_STATS_TIMER(DeepCopy);
+        sourceMat.copyTo(hostMat);
+        recordDeepCopy(static_cast<qint64>(hostMat.total() * hostMat.elemSize()));
+    }
+
+    mPendingMat.release();
+    mPendingRedBlueSwap = false;
+}
+
+cv::UMat& QCVimgCore::deviceTarget()
+{
+    // The host data gets overwritten on the next download, so a shared buffer isn't copied
+    if (!mQImg.isDetached()) {
+        mQImg = QImage(mQImg.size(), mQImg.format());
+        createMatFromQImage(mQImg, mMImg);
+        QCVIMG_STATS_RECORD(Allocation, mQImg.sizeInBytes());
+    } else {
+        const uchar* dataBefore = mQImg.constBits();
+
+        // Read-only external data (e.g. a mapped file) is copied by bits()
+        if (mQImg.bits() != dataBefore) {
+            createMatFromQImage(mQImg, mMImg);
+        }
+    }
+
+    // The whole host data gets replaced, so postponed data is not needed anymore
+    mPendingMat.release();
+    mPendingRedBlueSwap = false;
+    ++mGeneration;
+    mCachedPix = QPixmap();
+    mDirtyRegion = mQImg.rect();
+    mHashCached = false;
+    mDeviceDirty = true;
+
+    return mUMat;
+}
+
+void QCVimgCore::setMembersEmpty()
+{
+    mMImg = cv::Mat();
+    mQImg = QImage();
+    invalidateCaches();
+}
+
+bool QCVimgCore::pointersMatch() const
+{
+    if ( (mQImg.bits() == mMImg.data) ||
+         (mQImg.bits() == nullptr && (mMImg.data == NULL || mMImg.data == nullptr) ) )
+        // OpenCV still uses NULL, so it needs to be checked
+    {
+        return true;
+    } else {
+        return false;
+    }
+}
+
+bool QCVimgCore::sizesMatch() const
+{
+    return (mQImg.height() == mMImg.rows) && (mQImg.width() == mMImg.cols);
+}
+
+bool QCVimgCore::sizesMatch(const cv::Mat& first, const cv::Mat& second) const
+{
+    return first.cols == second.cols && first.rows == second.rows;
+}
+
+bool QCVimgCore::formatsMatch() const
+{
+    int matFrmt = convertQImgFormatTag(mQImg.format());
+
+    return matFrmt == mMImg.type();
+}
+
+bool QCVimgCore::typesMatch(const cv::Mat &first, const cv::Mat &second) const
+{
+    return first.type() == second.type();
+}
+
+bool QCVimgCore::matIsNull() const
+{
+    return (mMImg.cols == 0 && mMImg.rows == 0) &&
+           (mMImg.data == NULL || mMImg.data == nullptr); // OpenCV still uses NULL, so it needs to be checked
+}
+
+QDataStream& operator<<(QDataStream& ds, const QCVimgCore& img)
+{
+    img.writeTo(ds, StreamEncoding::Raw);
+    return ds;
+}
+
+QDataStream& operator>>(QDataStream& ds, QCVimgCore& img)
+{
+    int origQImgFormat, matRows, matCols, matType;
+
+    ds >> origQImgFormat;
+
+    if (origQImgFormat == QCVimgCore::scmStreamMagic) {
+        img.readRawFrom(ds);
+        return ds;
+    }
+
+    // The QImage is replaced below, so the Mat, postponed and device data
+    // describing the old buffer must not outlive it
+    img.mMImg.release();
+    img.invalidateCaches();
+
+    ds >> matRows
+       >> matCols
+       >> matType
+       >> img.mQImg;
+
+    /*
+     * The QImage reconstructed from the stream data doesn't always get the original format (Qt 5.13.2),
+     * so we need to convert back to original format in such cases.
+     */
+    if (img.mQImg.format() != QImage::Format(origQImgFormat)) {
+        img.mQImg.convertTo(QImage::Format(origQImgFormat));
+    }
+
+    img.mMImg = cv::Mat(matRows,
+                        matCols,
+                        matType,
+                        img.mQImg.bits(),
+                        static_cast<unsigned long>(img.mQImg.bytesPerLine()));
+    img.invalidateCaches();
+
+    return ds;
+}
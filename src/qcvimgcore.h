@@ -0,0 +1,1710 @@
+﻿#ifndef QCVIMGCORE_H
+#define QCVIMGCORE_H
+
+#include "qcvimglib_decl.h"
+#include "qcvimgconstref.h"
+#include "qcvimgexecution.h"
+#include "qcvimgpixel.h"
+#include "qcvimgpyramid.h"
+#include "qcvimgstats.h"
+#include "qcvimgview.h"
+
+#include <QFuture>
+#include <QIODevice>
+#include <QImage>
+#include <QMap>
+#include <QPixmap>
+#include <QRegion>
+#include <opencv4/opencv2/core/mat.hpp>
+
+#include <array>
+#include <limits>
+#include <type_traits>
+
+class QSharedMemory;
+class QThreadPool;
+
+using MatFormat = int;
+
+/**
+ * @brief Compile-time lookup tables of the formats compatible with QCVimgCore.
+ *
+ * The tables are indexed directly by QImage::Format and by the OpenCV type
+ * code respectively, so a lookup never needs more than a bounds check and an
+ * array access. Being constant expressions, they are also free of any static
+ * initialization (order) issues. See QCVimgCore for the list of compatible formats.
+ */
+namespace QCVimgFormatTable
+{
+    /**
+     * @brief Number of OpenCV types covered by the lookup table. Types with
+     * more than four channels are never compatible.
+     */
+    constexpr int scMatFormatCount = CV_MAKETYPE(CV_DEPTH_MAX - 1, 4) + 1;
+
+    constexpr MatFormat qtToCvFormat(QImage::Format qFormat)
+    {
+        switch (qFormat) {
+        case QImage::Format_RGB32:
+        case QImage::Format_ARGB32:
+        case QImage::Format_RGBX8888:
+        case QImage::Format_RGBA8888:
+            return CV_8UC4;
+        case QImage::Format_RGB888:
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        case QImage::Format_BGR888:
+#endif
+            return CV_8UC3;
+        case QImage::Format_Alpha8:
+        case QImage::Format_Grayscale8:
+            return CV_8UC1;
+        case QImage::Format_Grayscale16:
+            return CV_16UC1;
+        case QImage::Format_RGBX64:
+        case QImage::Format_RGBA64:
+            return CV_16UC4;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 2, 0)
+        case QImage::Format_RGBX32FPx4:
+        case QImage::Format_RGBA32FPx4:
+            return CV_32FC4;
+#endif
+        default:
+            return -1;
+        }
+    }
+
+    constexpr QImage::Format cvToQtFormat(MatFormat matFormat)
+    {
+        switch (matFormat) {
+        case CV_8UC1:
+            return QImage::Format_Grayscale8;
+        case CV_8UC3:
+            return QImage::Format_RGB888;
+        case CV_8UC4:
+            return QImage::Format_ARGB32;
+        case CV_16UC1:
+            return QImage::Format_Grayscale16;
+        case CV_16UC4:
+            return QImage::Format_RGBA64;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 2, 0)
+        case CV_32FC4:
+            return QImage::Format_RGBA32FPx4;
+#endif
+        default:
+            return QImage::Format_Invalid;
+        }
+    }
+
+    constexpr std::array<MatFormat, QImage::NImageFormats> makeQtToCvTable()
+    {
+        std::array<MatFormat, QImage::NImageFormats> table{};
+
+        for (int qFormat = 0; qFormat < QImage::NImageFormats; ++qFormat) {
+            table[qFormat] = qtToCvFormat(static_cast<QImage::Format>(qFormat));
+        }
+
+        return table;
+    }
+
+    constexpr std::array<QImage::Format, scMatFormatCount> makeCvToQtTable()
+    {
+        std::array<QImage::Format, scMatFormatCount> table{};
+
+        for (int matFormat = 0; matFormat < scMatFormatCount; ++matFormat) {
+            table[matFormat] = cvToQtFormat(matFormat);
+        }
+
+        return table;
+    }
+
+    inline constexpr std::array<MatFormat, QImage::NImageFormats> scQtToCv = makeQtToCvTable();
+    inline constexpr std::array<QImage::Format, scMatFormatCount> scCvToQt = makeCvToQtTable();
+}
+
+/**
+ * @brief Compile-time properties of a QImage format.
+ *
+ * Allows code that knows its image format at compile time to skip the runtime
+ * format checks entirely (see QCVimgT).
+ */
+template<QImage::Format Format>
+struct QCVimgFormatTraits
+{
+    /// The equivalent OpenCV format, -1 if incompatible.
+    static constexpr MatFormat matFormat = QCVimgFormatTable::qtToCvFormat(Format);
+    /// True if QCVimgCore is able to work with the format.
+    static constexpr bool isValid = matFormat != -1;
+    /// Number of channels of the equivalent OpenCV format, 0 if incompatible.
+    static constexpr int channels = isValid ? CV_MAT_CN(matFormat) : 0;
+};
+
+/**
+ * @brief Allows to tell functions what color order the cv::Mat argument has.
+ * @see QCVimgCore
+ * @see copyFrom
+ * @see swapMatRedBlue
+ * @see convertQColorToScalar
+ */
+enum class MatColorOrder : uint8_t {RGB, BGR};
+
+enum class DataPrio : bool {Low=true, Hi=false};
+
+/**
+ * @brief Tells when the data handed over to an image is copied or swizzled
+ * into its bound form.
+ *
+ * With Eager (the default) it happens right away. With Lazy the image gets
+ * its final size and format immediately, but the copy (or red-blue swap) is
+ * only done when the data is first accessed through either member, just like
+ * the download of a device resident image. Frames that are dropped, or only
+ * get overwritten, never pay for it.
+ * @see QCVimgCore::setBindingMode
+ */
+enum class BindingMode : uint8_t {Eager, Lazy};
+
+/**
+ * @brief Interpolation methods available for the OpenCV based resize functions.
+ *
+ * They correspond to cv::INTER_NEAREST, cv::INTER_LINEAR, cv::INTER_CUBIC and
+ * cv::INTER_AREA respectively. Area is the recommended method for downscaling.
+ * @see QCVimgCore::resizeInto
+ */
+enum class ResizeInterpolation : uint8_t {Nearest, Linear, Cubic, Area};
+
+/**
+ * @brief Encodings available for serializing a QCVimgCore into a QDataStream.
+ *
+ * Raw writes a small versioned header followed by the uncompressed
+ * scanlines, which is the fastest option (e.g. for IPC or frame caches). Png
+ * streams the QImage member as Qt does, which is slower but more compact.
+ * @see QCVimgCore::writeTo
+ */
+enum class StreamEncoding : uint8_t {Raw, Png};
+
+/**
+ * @brief Tells QCVimgCore::hash whether the result may be cached.
+ *
+ * A cached hash stays valid until the image is modified through QCVimgCore,
+ * modifications through cv::Mat copies taken earlier can't be detected.
+ * @see QCVimgCore::hash
+ */
+enum class HashCaching : uint8_t {Disabled, Enabled};
+
+/**
+ * @brief A value type allowing simultaneous work with QImage and cv::Mat on
+ * the same data
+ *
+ * QCVimgCore holds the image data and implements all of the functionality of
+ * QCVimg, but isn't a QObject: it needs no extra private data allocation, has
+ * no parent bookkeeping and can be moved cheaply (and noexcept), which makes
+ * it the better choice for large containers of images (e.g. thumbnails). QCVimg
+ * is a thin QObject wrapper over it for code relying on QObject ownership.
+ *
+ * The QCVimgCore class provides a convenient way to work with both QImage and cv::Mat
+ * classes simultaneously. The image data is shared between both classes, but
+ * allocation (and memory management in general) is always done by QImage, thus
+ * cv::Mat serves only as a different type of interface to the same data. Because
+ * QImage uses the copy-on-write (COW) technique, an explicit and immediate copy
+ * of the image data is performed when creating a QCVimgCore instance from an lvalue
+ * to prevent unexpected behavior while working with cv::Mat (e.g. pointing to
+ * the wrong data).
+ *
+ * At this time, references to the underlying full-featured QImage and cv::Mat
+ * classes are also provided, but using any of their built-in functionality
+ * might easily cause unexpected or undefined behavior bacause of possible
+ * reallocations or change in the data representation. Only QCVimgCore provided
+ * functions guarantee synchronization between the two image classes. Also,
+ * users should be very careful while using library functions as well, as they
+ * might equally cause implicit reallocations (especially true for OpenCV
+ * functions) and all the problems with them.
+ *
+ * Although QCVimgCore doesn't employ COW itself, using the QImage member through
+ * the reference will. Users should also remember that cv::Mat uses shallow
+ * copy, so special care must be taken if moving QCVimgCore after creating a cv::Mat
+ * copy from the underlying cv::Mat member of QCVimgCore,
+ *
+ * _Thread safety:_ QCVimgCore is reentrant, but not thread-safe. Different
+ * instances can be used from different threads at the same time, even if
+ * they share data (QImage and cv::Mat reference counting is atomic, and so
+ * are the library's own statics, like the instrumentation counters of
+ * QCVimgStats). A single instance must not be accessed from several threads
+ * concurrently, not even through const functions only: those may update
+ * internal caches (host synchronization, lazy binding, hash and pixmap
+ * cache), and the QImage and cv::Mat members are only consistent between
+ * calls. Instead of locking an instance and copying it under the lock, use
+ * one of the following:
+ * - #share for concurrent readers: a QCVimgConstRef never changes, and the
+ *   original image detaches from it before being modified.
+ * - QCVimgQueue or QCVimgTripleBuffer to pass ownership of an image to
+ *   another thread by moving it, without copying the data.
+ *
+ * #qPix and #qPixUpdate must only be called from the GUI thread. An image
+ * with a cached pixmap releases the cache on the thread modifying, moving or
+ * destroying it. Moving or swapping an image never carries the cached pixmap
+ * over, so a moved image can be processed on another thread safely, and
+ * only converts again when #qPix is called on it.
+ *
+ * Because QImage and cv::Mat are vastly different, only a small fraction of
+ * common functionality is possible, which is especially true for the image
+ * formats. As of now, only a basic (most commonly used) set of formats are
+ * supported.
+ *
+ * _Supported Qt to OpenCV format conversions:_
+ * QImage format                       | OpenCV format
+ * ------------------------------------|--------------
+ * QImage::Format_RGB32                | CV_8UC4
+ * QImage::Format_ARGB32               | CV_8UC4  _See note below!_
+ * QImage::Format_RGBX8888             | CV_8UC4
+ * QImage::Format_RGBA8888             | CV_8UC4
+ * QImage::Format_RGB888               | CV_8UC3
+ * QImage::Format_BGR888 (Qt >= 5.14)  | CV_8UC3
+ * QImage::Format_Alpha8               | CV_8UC1
+ * QImage::Format_Grayscale8           | CV_8UC1
+ * QImage::Format_Grayscale16          | CV_16UC1
+ * QImage::Format_RGBX64               | CV_16UC4
+ * QImage::Format_RGBA64               | CV_16UC4
+ * QImage::Format_RGBX32FPx4 (Qt >= 6.2) | CV_32FC4
+ * QImage::Format_RGBA32FPx4 (Qt >= 6.2) | CV_32FC4
+ *
+ * _Supported OpenCV to Qt format conversions:_
+ * OpenCV format | QImage format
+ * --------------|--------------
+ * CV_8UC1       | QImage::Format_Grayscale8
+ * CV_8UC3       | QImage::Format_RGB888
+ * CV_8UC4       | QImage::Format_ARGB32
+ * CV_16UC1      | QImage::Format_Grayscale16
+ * CV_16UC4      | QImage::Format_RGBA64
+ * CV_32FC4      | QImage::Format_RGBA32FPx4 (Qt >= 6.2)
+ *
+ * The OpenCV to Qt direction picks a default for every type, other QImage
+ * formats with the same layout (e.g. Format_BGR888 for native BGR frames) can
+ * be requested with the QCVimgCore(const cv::Mat&, QImage::Format)
+ * constructors. Single channel floating point data (CV_32FC1) has no QImage
+ * equivalent, so it can't be bound.
+ *
+ * _IMPORTANT:_ In case of any 32 bit format (CV_8UC4) there is a mismatch
+ * between QImage and cv::Mat color order. cv::Mat will return colors in BGRA
+ * order, which will correspond to a color order of ARGB in a QColor. This means
+ * that QColor.alpha() will match to the cv::Mat Blue channel, QColor.red() to
+ * cv::Mat Green channel, etc. The reason why cv::cvtColor or cv::mixChannels
+ * doesn't change the order of colors in such cases is not yet known, and as such
+ * providing a cv::Mat that matches the QImage color order for 32 bit images is
+ * not possible at this time.
+ */
+
+class QCVIMGLIB_EXPORT QCVimgCore
+{
+public:
+    /**
+     * @brief Process wide counters of the copies done by QCVimgCore.
+     * @see copyStats
+     */
+    struct CopyStats
+    {
+        /// Number of times #detach (or #mutableBits) had to copy shared data.
+        quint64 detaches = 0;
+        /// Number of deep copies of data into an image, made by copy
+        /// construction, assignment, #copy and postponed (lazy) copies.
+        quint64 deepCopies = 0;
+    };
+
+    /**
+     * @brief Default constructor.
+     *
+     * For both QImage and and cv::Mat members their respective default
+     * constructors are called.
+     */
+    QCVimgCore() noexcept = default;
+
+    /**
+     * @brief Copy constructor with deep copy.
+     *
+     * After creating a deep copy of @p img it ties the cv::Mat member to the
+     * copied data.
+     * @param img Source image to copy from.
+     */
+    QCVimgCore(const QCVimgCore& img);
+
+    /**
+     * @brief Copy assignment operator with deep copy.
+     *
+     * It makes a deep copy of @p img and then ties the cv::Mat member to the
+     * copied data.
+     * @param img Source image to copy from.
+     */
+    QCVimgCore& operator=(const QCVimgCore& img);
+
+    /**
+     * @brief Move constructor.
+     *
+     * After moving the QImage member normally from @p img, it simply copies
+     * the cv::Mat member, since cv::Mat uses shallow copy (and has no move
+     * semantics). The cv::Mat member in @p img is then overwritten with a default
+     * constructed (empty) Mat to decrease the reference counter and to prevent
+     * unexpected data modification.
+     * @param img Source image to move from.
+     */
+    QCVimgCore(QCVimgCore&& img) noexcept;
+
+    /**
+     * @brief Move assignment operator.
+     *
+     * Does the same as the move constructor. @p img is left empty, it doesn't
+     * keep the previous data of this image alive.
+     * @param img Source image to move from.
+     */
+    QCVimgCore& operator=(QCVimgCore&& img) noexcept;
+
+    /**
+     * Transfers arguments directly to the appropriate QImage constructor, so size
+     * checking is done there to avoid duplication. @p format on the other hand is
+     * checked to allow the construction of QImages that have a compatible cv::Mat
+     * format only. If an incompatible format is provided, then this constructor
+     * equals in functionality to the default constructor (e.g. an empty image
+     * is created).
+     * @param width Number of columns in a 2D image.
+     * @param height Number of rows in a 2D image.
+     * @param format In-memory format of image to be created. See
+     * #convertQImgFormatTag and #convertMatFormatTag for valid formats.
+     */
+    QCVimgCore(int width, int height, QImage::Format format);
+
+    /**
+     * @brief Constructs from QImage with deep copy.
+     *
+     * Creates a deep copy of the @p img if the image had a compatible format,
+     * then ties cv::Mat member to the data. On an incompatible format an
+     * empty image is created.
+     * @param img Source image to copy from.
+     */
+    explicit QCVimgCore(const QImage& img);
+
+    /**
+     * @brief Constructs from QImage with move semantics.
+     *
+     * Moves from QImage member of @p img after checking for a compatible image
+     * format, then ties cv::Mat member to the data. On an incompatible format
+     * an empty image is created and the original is not touched.
+     * @param img Source image to move from.
+     */
+    explicit QCVimgCore(QImage&& img);
+
+    /**
+     * @brief Constructs from cv::Mat with deep copy.
+     *
+     * Creates a deep copy of @p img if the image had a compatible format. Memory
+     * management is performed by the QImage member by first calling the QImage
+     * constructor with the size and converted format provided by @p img. After
+     * the cv::Mat member is tied to the newly allocated QImage, the data is
+     * finally copied into it.
+     * @param img Source image to copy from.
+     * @param sourceMatColorOrder Allows to inform the function whether
+     * @sourceMat has RGB or BGR color ordering. If BGR is provided and the
+     * image is a three channel image, the red and blue channels are swapped to
+     * facilitate proper interoperability between cv::Mat and QImage. The final
+     * image will always have an RGB color ordering. If source image is a single
+     * or four channel image, this argument has no effect (four channel images
+     * are expected in the BGRA order matching QImage::Format_ARGB32, RGBA data
+     * can be converted with #swapMatRedBlue beforehand).
+     * @see MatColorOrder
+     */
+    explicit QCVimgCore(const cv::Mat& img, MatColorOrder sourceColorOrder = MatColorOrder::RGB);
+
+    /**
+     * @brief Constructs from cv::Mat by adopting its buffer (no copy).
+     *
+     * Instead of allocating a new QImage and copying the data over, the QImage
+     * member is constructed directly on top of the buffer of @p img, and the
+     * cv::Mat member is tied to it as usual. The moved-in cv::Mat header is kept
+     * alive until the last QImage referencing the buffer is destroyed, so the
+     * reference counter of the buffer guarantees its lifetime. @p img is left
+     * empty after the call.
+     *
+     * If BGR color order is provided for a three channel image, the red and blue
+     * channels are swapped in place, which means that any other cv::Mat sharing
+     * the same buffer will see the change as well. If @p img doesn't own its data
+     * (e.g. it was constructed on top of an external buffer) or it isn't a two
+     * dimensional image, adoption is not possible and a deep copy is made just
+     * like with the lvalue overload. On an incompatible format an empty image is
+     * created and the original is not touched.
+     * @param img Source image to adopt the buffer of.
+     * @param sourceColorOrder See the lvalue overload for details.
+     * @param bindingMode With BindingMode::Lazy the channel swap of an adopted
+     * BGR image is postponed until the data is first accessed. The image keeps
+     * the mode, see #setBindingMode.
+     * @see MatColorOrder
+     */
+    explicit QCVimgCore(cv::Mat&& img, MatColorOrder sourceColorOrder = MatColorOrder::RGB,
+                        BindingMode bindingMode = BindingMode::Eager);
+
+    /**
+     * @brief Constructs from cv::Mat with deep copy, keeping its data as is in
+     * the given QImage @p format.
+     *
+     * Unlike the other cv::Mat constructors, the channels are never swapped,
+     * the data is interpreted as @p format instead. E.g. native BGR OpenCV
+     * frames (CV_8UC3) can be used as QImage::Format_BGR888, RGBA data
+     * (CV_8UC4) as QImage::Format_RGBA8888.
+     * @param img Source image to copy from.
+     * @param format A QImage format equivalent to the type of @p img, on any
+     * other format an empty image is created.
+     */
+    QCVimgCore(const cv::Mat& img, QImage::Format format);
+
+    /**
+     * @brief Constructs from cv::Mat by adopting its buffer (no copy), keeping
+     * its data as is in the given QImage @p format.
+     *
+     * Adopts the buffer just like QCVimgCore(cv::Mat&&, MatColorOrder), but
+     * the data is never modified, so e.g. a native BGR frame adopted as
+     * QImage::Format_BGR888 needs neither a copy nor a channel swap.
+     * @param img Source image to adopt the buffer of.
+     * @param format A QImage format equivalent to the type of @p img, on any
+     * other format an empty image is created and @p img is not touched.
+     */
+    QCVimgCore(cv::Mat&& img, QImage::Format format);
+
+    /**
+     * @brief Returns the size of image data as reported by QImage.
+     *
+     * Please refer to QImage documentation for more info.
+     */
+    qsizetype bytes() const;
+
+    /**
+     * @brief Copies and converts the image into the provided @p format.
+     *
+     * In case an invalid format is provided, an empty image is returned. The
+     * original data is left unchanged. The most common conversions (e.g.
+     * between RGB888, RGB32/ARGB32 and the grayscale formats) are done by
+     * dedicated vectorized OpenCV kernels, which write directly into the newly
+     * allocated image. All other conversions are done by
+     * QImage::convertToFormat(), the result of which is moved into the returned
+     * instance without any further copy.
+     *
+     * Conversions into QImage::Format_Grayscale8 through the dedicated kernels
+     * use the same weights as qGray(), but the result might be off by one
+     * because of rounding. The dedicated kernels run on the threads of the
+     * current QCVimgExecution.
+     * @param format Target format to convert the image into.
+     * @return A copy of the original image converted into the format provided
+     * in @p format
+     */
+    QCVimgCore convertToFormat(QImage::Format format) const;
+
+    /**
+     * @brief Does the same as #convertToFormat, but on a worker thread.
+     *
+     * The worker reads the data through a shared handle (see #share), so
+     * nothing is copied up front and the image can be modified (or destroyed)
+     * while the conversion runs. The result is delivered as a read-only
+     * handle, since QFuture copies its results and a copy of a QCVimgCore is
+     * always deep; QCVimgConstRef::copy creates a modifiable image from it.
+     * The current QCVimgExecution of the calling thread is used by the worker
+     * as well.
+     * @param format The requested format.
+     * @param pool The thread pool to run on, QThreadPool::globalInstance() if
+     * nullptr.
+     * @return A future of the converted image, which is empty in the same
+     * cases as with #convertToFormat, or if the image isn't bound.
+     */
+    QFuture<QCVimgConstRef> convertToFormatAsync(QImage::Format format, QThreadPool* pool = nullptr) const;
+
+    /**
+     * @brief Converts the image into the provided @p format, writing the result
+     * into an existing destination image.
+     *
+     * Works like #convertToFormat, but if @p dest already has the size of this
+     * image and @p format (and its data isn't shared with another QImage), its
+     * buffer is reused instead of allocating a new one. Conversions without a
+     * dedicated kernel are done through QImage::convertToFormat(), in which
+     * case the result is copied into @p dest.
+     * @param dest Destination image. Must not be the image itself.
+     * @param format Target format to convert the image into.
+     * @return 0 on success, -1 if invalid format was provided, the image is
+     * empty or its cv::Mat member isn't bound, or if @p dest is the image itself.
+     */
+    int convertInto(QCVimgCore& dest, QImage::Format format) const;
+
+    /**
+     * @brief Converts the image into the provided @p format in place.
+     *
+     * Calls QImage::convertTo() on the QImage member, which reuses the existing
+     * buffer whenever the conversion allows it (e.g. if the pixel size doesn't
+     * change), then rebinds the cv::Mat member to the result. In case an
+     * invalid format is provided, the image is left unchanged.
+     * @param format Target format to convert the image into.
+     * @param flags See Qt documentation for more info.
+     * @return 0 on successful conversion, -1 if the image is empty or an
+     * invalid format was provided.
+     */
+    int convertTo(QImage::Format format, Qt::ImageConversionFlags flags = Qt::AutoColor);
+
+    /**
+     * @brief Makes deep copy of @p sourceQImg and ties the cv::Mat member to
+     * the copied data.
+     *
+     * In case @p sourceQImg has an incompatible format, the data inside QCVimgCore
+     * is left unchanged.
+     * @param sourceQImg QImage to copy from.
+     * @return 0 for successful copy, -1 if invalid format was provided.
+     */
+    int copy(const QImage& sourceQImg);
+
+    /**
+     * @brief Makes deep copy of @p sourceMat and ties the cv::Mat member to the
+     * copied data.
+     *
+     * Memory management is performed by the QImage member, as a new empty
+     * instance is created with the size and converted format provided by
+     * @p sourceMat. After the cv::Mat member has been tied to the new QImage,
+     * the data from @p sourceMat is finally copied into it. If the existing
+     * size and format matches that of @p sourceMat, no new allocations are
+     * performed, the data is simply copied over. If @p sourceMat has
+     * incompatible type, no action is performed.
+     * @param sourceMat Source Mat to copy from.
+     * @param sourceMatColorOrder Allows to inform the function whether
+     * @p sourceMat has RGB or BGR color ordering. If BGR is provided and the
+     * image is a three channel image, the red and blue channels are swapped to
+     * facilitate proper interoperability between cv::Mat and QImage. The final
+     * image will always have an RGB color ordering. If source image is a single
+     * or four channel image, this argument has no effect.
+     * @return 0 for successful copy, -1 if invalid format was provided.
+     */
+    int copy(const cv::Mat& sourceMat, MatColorOrder sourceMatColorOrder = MatColorOrder::RGB);
+
+    /**
+     * @brief Makes deep copy of image to @p dest.
+     *
+     * This function uses the cv::Mat member to copy the data from, and calls its
+     * native copy function (which is also copyTo, see OpenCV documentation). The
+     * user must also make sure that the Mat member is indeed bound to the QImage
+     * data (by calling #isMatBound first) in order to get the desired effects.
+     * @param dest OpenCV array to copy the data to. See OpenCV documentation for
+     * more information on OutputArray.
+     */
+    void copyTo(cv::OutputArray dest) const;
+
+    /**
+     * @brief Makes deep copy of image to @p dest.
+     *
+     * Directly calls the copy() function of QImage. See Qt documentation for more
+     * details.
+     * @param dest QImage to copy the data to.
+     */
+    void copyTo(QImage& dest) const;
+
+    /**
+     * @brief Returns a non-const reference to the cv::Mat member.
+     *
+     * This is provided to facilitate work with the vast OpenCV library, although
+     * extreme caution must be taken. A lot of OpenCV functions will try to
+     * reallocate data or modify the image metadata implicitly in a way that
+     * would break compatibility between the QImage and cv::Mat members.
+     * Unfortunately, it is not really well documented how OpenCV functions work
+     * when not the cv::Mat is responsible for memory management, so a lot of
+     * unexpected results or crashes are to be expected if not careful. The best
+     * way to avoid such undesired behavior is to make sure that a temporary
+     * cv::Mat is used for functions known to modifiy aforementioned properties,
+     * and only the end result is copied into QCVimgCore with one of the provided
+     * methods. It is also extremely important to remember, that cv::Mat uses
+     * shallow copy, so a simple assignment will not prevent the problems from
+     * happening. Any modification done on the cv::Mat metadata outside the
+     * boundaries of QCVimgCore will not get the QImage member updated! Using
+     * QCVimgCore's #copyFrom , #copyTo and #isMatBound is highly advised.
+     *
+     * As the returned reference allows modifying the data, the image is
+     * detached first (see #detach), so handles created by #share stay
+     * unchanged. Getting the reference advances the #generation and drops the
+     * cached hash, so #qPix and #hash don't return stale results. Only the
+     * dirty region isn't updated, the written area should be reported with
+     * #markDirty for #qPixUpdate.
+     */
+    cv::Mat& cvMat();
+
+    /**
+     * @brief Returns a const reference to the cv::Mat member.
+     *
+     * An overload of the previous function, some of the same warnings apply.
+     */
+    const cv::Mat& cvMat() const;
+
+    /**
+     * @brief Copies the image data into a device (OpenCL) buffer, making the
+     * image device resident.
+     *
+     * While the image is device resident, the OpenCV based #resize,
+     * #resizeInto, #convertToFormat and #convertInto (for the conversions
+     * with a dedicated kernel) run on the device through OpenCV's transparent
+     * API, and their results stay on the device as well. The host data is
+     * only brought up to date (downloaded) when it's accessed, e.g. through
+     * #qImg, #cvMat or #qPix, so chained operations don't transfer the data
+     * back and forth. Without OpenCL, OpenCV runs the same code on the CPU.
+     *
+     * Modifying the host data (anything that calls #detach) makes the device
+     * copy stale, so it is released. Calling the function on a device
+     * resident image does nothing.
+     * @return 0 on success, -1 if the image is empty or its cv::Mat member
+     * isn't bound.
+     */
+    int upload();
+
+    /**
+     * @brief Brings the host data up to date with the device data, keeping
+     * the image device resident.
+     *
+     * Normally there is no need to call this, as accessing the host data
+     * downloads it automatically.
+     * @return 0 on success, -1 if the image isn't device resident.
+     */
+    int download();
+
+    /**
+     * @brief Downloads the device data if needed, then releases the device
+     * buffer.
+     */
+    void releaseDevice();
+
+    /**
+     * @brief Returns true if the image has an up to date copy of its data on
+     * the device (see #upload).
+     */
+    bool isDeviceResident() const;
+
+    /**
+     * @brief Returns a reference to the device copy of the image data, for
+     * calling OpenCV functions on it.
+     *
+     * The image is uploaded first if needed. The data is expected to be
+     * modified through the reference, so the host data is downloaded on its
+     * next access. Just like with #cvMat, the size and type of the cv::UMat
+     * mustn't be changed.
+     *
+     * _IMPORTANT:_ As the host data is downloaded lazily, even const member
+     * functions accessing the host data may write it, so a device resident
+     * image mustn't be accessed from multiple threads at the same time.
+     */
+    cv::UMat& uMat();
+
+    /**
+     * @brief Returns a const reference to the device copy of the image data,
+     * uploading the image first if needed.
+     */
+    const cv::UMat& uMat() const;
+
+    /**
+     * @brief Makes sure the image data isn't shared with any other QImage.
+     *
+     * If the QImage member shares its data (see #shared), the data is copied
+     * and the cv::Mat member is rebound to the copy (unless it pointed to
+     * different data already). Otherwise nothing but releasing the device
+     * copy (see #upload) happens, so it is cheap to call before modifying the
+     * data. Detaching doesn't count as a modification, see #markDirty.
+     * Detaching through this function (or #mutableBits) instead of calling
+     * bits() on #qImg makes explicit calls to #rebindMat after a detach
+     * unnecessary.
+     * @return True if the data had to be copied, otherwise false.
+     * @see copyStats
+     */
+    bool detach();
+
+    /**
+     * @brief Tells if image is empty.
+     *
+     * Checks both QImage and cv::Mat members for emptiness to make sure the
+     * instance truly has no data in it. This will only be true if both QImage
+     * and cv::Mat members point to null pointers and report zero size (height
+     * and width) at the same time.
+     *
+     * It is important to know, that if the user accidentally used the cv::Mat
+     * member separately from the QImage and memory was allocated through it,
+     * reducing the cv::Mat size to zero does not necessarily mean that memory
+     * will be deallocated as well, so this function will report false in these
+     * cases. Calling the release() method of the cv::Mat member in such cases
+     * probably will fix the problem. See OpenCV documentation for more
+     * information.
+     * @return Only true if both QImage and cv::Mat members are empty, otherwise
+     * false. See description for more information.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Fill image with color.
+     *
+     * The value is interpreted the same way as by QImage's appropriate fill()
+     * function (see Qt documentation for more info), but the image is written
+     * by the QCVimgFill kernels, which use the threads of the current
+     * QCVimgExecution and streaming stores for large images.
+     * @param pixelValue color to be used to fill image.
+     */
+    void fill(uint pixelValue);
+
+    /**
+     * @brief Fill image with color.
+     *
+     * See the previous overload.
+     * @param color color to be used to fill image.
+     */
+    void fill(const QColor& color);
+
+    /**
+     * @brief Fill image with color.
+     *
+     * See the previous overloads.
+     * @param color color to be used to fill image.
+     */
+    void fill(const Qt::GlobalColor color);
+
+    /**
+     * @brief Fills a rectangular region of the image with color.
+     * @param color color to be used to fill the region.
+     * @param rect Region to fill, clipped to the image boundaries.
+     */
+    void fill(const QColor& color, const QRect& rect);
+
+    /**
+     * @brief Fills the image (or a region of it) through the cv::Mat member.
+     *
+     * The channels of @p value are reordered according to @p valueColorOrder
+     * to match the memory layout of the image, so e.g. a cv::Scalar created by
+     * #convertQColorToScalar gives the same color as filling with the QColor.
+     * As with OpenCV, the fourth channel (alpha) is taken from value[3].
+     * @param value Value of the channels, saturated to the depth of the image.
+     * @param valueColorOrder Color order of @p value, see #MatColorOrder.
+     * @param rect Region to fill, clipped to the image boundaries. A null rect
+     * fills the whole image.
+     * @return 0 on success, -1 if the image is empty or its cv::Mat member
+     * isn't bound.
+     */
+    int fill(const cv::Scalar& value, MatColorOrder valueColorOrder, const QRect& rect = QRect());
+
+    /**
+     * @brief Returns a hash of the image format, size and pixel data.
+     *
+     * Equal images (see #operator==) always have equal hashes, so hashes can
+     * be used for finding duplicates (e.g. in a QHash) instead of pairwise
+     * comparisons. The data is hashed with qHashBits, ignoring the same bytes
+     * as #operator==.
+     * @param caching If enabled, the hash is computed only on the first call
+     * and returned from a cache until the image is modified. Caching isn't
+     * thread-safe, so concurrent calls on the same image must not enable it.
+     * @return The hash value.
+     */
+    size_t hash(HashCaching caching = HashCaching::Disabled) const;
+
+    /**
+     * @brief Returns height of the image.
+     * @return Height of the image.
+     */
+    int height() const;
+
+    /**
+     * @brief Tells if the cv::Mat member is properly bound to the QImage member.
+     *
+     * All three of the following must be true, in order to consider the Mat
+     * member to be properly bound:
+     * 1. Both Mat and QImage point to the same data in memory.
+     * 2. Both Mat and QImage report the same width and height.
+     * 3. Both Mat and QImage report equivalent image formats.
+     *
+     * Furthermore, there are two possibilities when the Mat member is considered
+     * to point to the QImage data:
+     * 1. both members return the same pointer.
+     * 2. both members point to nullptr (NULL is also accepted in case of cv::Mat,
+     * see OpenCV docs for reasons).
+     *
+     * @return true if Mat member is bound, otherwise false. See description for
+     * details.
+     */
+    bool isMatBound() const;
+
+    /**
+     * @brief Loads an image file, decoding it directly into the bound buffer.
+     *
+     * If the image already has the size and format of the decoded image and
+     * its data isn't shared, the buffer is reused, so loading a series of
+     * similar images needs no allocation. See QCVimgReader for details and
+     * for more options (e.g. pooled buffers).
+     * @param fileName The file to load.
+     * @param format Format of the file (e.g. "png"), autodetected if nullptr.
+     * @return 0 on success, -1 if the file couldn't be read, in which case the
+     * image is left empty.
+     */
+    int load(const QString& fileName, const char* format = nullptr);
+
+    /**
+     * @brief Returns the image's format in OpenCV notation.
+     *
+     * For more information about what these numbers mean, check the OpenCV
+     * documentation.
+     * @return Image format in OpenCV notation.
+     */
+    int matFormat() const;
+
+    /**
+     * @brief Returns a pointer to the image data which is safe to modify.
+     *
+     * Calls #detach first, so the cv::Mat member always points to the returned
+     * data. Unlike the non-const #qImg and #cvMat accessors, this counts as a
+     * modification of the whole image (see #markDirty).
+     * @return Pointer to the first scanline, or nullptr for empty images.
+     */
+    uchar* mutableBits();
+
+    /**
+     * @brief Returns the image's format in Qt notation.
+     *
+     * For more information on what the formats mean, check the Qt documentation.
+     * @return Image format in Qt notation.
+     */
+    QImage::Format qFormat() const;
+
+    /**
+     * @brief Compares two images for equality.
+     *
+     * The image data is compared with the same rules as QImage's operator==()
+     * (e.g. the unused byte of Format_RGB32 pixels and the padding at the end
+     * of the scanlines are ignored), but with a memcmp per scanline (or a
+     * single one for unpadded images). Images differing in size or format
+     * are rejected without looking at the data. Cached hashes (see #hash) are
+     * not used for this, since data written without being reported (e.g.
+     * through #scanLine) would make them stale. To make the two images truly equal the cv::Mat
+     * members have to be bound to their respective QImages as well.
+     * @return True if QImage members are equal and cv::Mat members are bound
+     * in both images, otherwise false.
+     * @see operator!=
+     * @see isMatBound
+     */
+    bool operator==(const QCVimgCore& other) const;
+
+    /**
+     * @brief Compares two images for equality.
+     *
+     * @return True if QImage members are not equal or any of the cv::Mat members
+     * are not bound, otherwise false.
+     * @see operator==
+     */
+    bool operator!=(const QCVimgCore& other) const;
+
+    /**
+     * @brief Allows serialization of class using QDataStream (output)
+     *
+     * Uses the raw encoding, see #writeTo for storing PNG encoded data.
+     */
+    friend QDataStream& operator<<(QDataStream& ds, const QCVimgCore& img);
+
+    /**
+     * @brief Allows serialization of class using QDataStream (input)
+     *
+     * The encoding is detected automatically. Raw encoded data is read directly
+     * into the QImage member, reusing its buffer if the size and format already
+     * match. On invalid raw data the image is set empty and the status of
+     * @p ds is set to QDataStream::ReadCorruptData.
+     */
+    friend QDataStream& operator>>(QDataStream& ds, QCVimgCore& img);
+
+    /**
+     * @brief Returns non-const reference to the QImage member.
+     *
+     * This is provided to facilitate work with the Qt framework, although extreme
+     * caution must be taken. Some Qt functions might try to reallocate data or
+     * modify the image metadata implicitly in a way that would break compatibility
+     * between the QImage and cv::Mat members. The best way to avoid such undesired
+     * behavior is to make sure that a temporary QImage is used for functions
+     * known to modifiy aforementioned properties, and only the end result is
+     * copied into QCVimgCore with one of the provided methods. Any modification
+     * done on the QImage metadata outside the boundaries of QCVimgCore will not
+     * get the cv::Mat member updated! Using QCVimgCore's #copy , #copyTo and
+     * #isMatBound is highly advised.
+     *
+     * As the returned reference allows modifying the data, the image is
+     * detached first (see #detach), so handles created by #share stay
+     * unchanged. Getting the reference advances the #generation and drops the
+     * cached hash, so #qPix and #hash don't return stale results. Only the
+     * dirty region isn't updated, the written area should be reported with
+     * #markDirty for #qPixUpdate.
+     */
+    QImage& qImg();
+
+    /**
+     * @brief Returns a const reference to the QImage member.
+     *
+     * An overload of the previous function, some of the same warnings apply.
+     */
+    const QImage& qImg() const;
+
+    /**
+     * @brief Returns a QPixmap generated from the internal QImage
+     *
+     * This is a convenience function, which calls QPixmap's built-in function
+     * to create a QPixmap. The pixmap is cached, so as long as the image isn't
+     * modified (see #generation), repeated calls with the same @p flags return
+     * the same (shared) pixmap without converting or uploading anything. The
+     * cache keeps the pixmap alive until the image is modified, moved from or
+     * destroyed, so an image with a cached pixmap should only be modified,
+     * moved from or destroyed in the GUI thread as well. The cache is not moved
+     * or swapped along with the data. Like any QPixmap function, this must
+     * only be called in the GUI thread.
+     */
+    QPixmap qPix(Qt::ImageConversionFlags flags = Qt::AutoColor) const &;
+
+    /**
+     * @brief Moves the internal QImage into a new QPixmap, leaving the image
+     * empty.
+     *
+     * As the QImage doesn't need to be kept, QPixmap can convert it in place
+     * instead of copying it first (unless its data is shared).
+     */
+    QPixmap qPix(Qt::ImageConversionFlags flags = Qt::AutoColor) &&;
+
+    /**
+     * @brief Returns a counter that changes every time the image data is
+     * modified through QCVimgCore, or marked changed with #markDirty.
+     *
+     * The non-const #qImg and #cvMat accessors advance it as well, since the
+     * data may be written through the returned reference. The per-row
+     * #scanLine and #rows accessors (and #detach) don't, writes through them
+     * have to be reported with #markDirty.
+     *
+     * Comparing it to a value stored earlier tells whether anything derived
+     * from the image (e.g. a thumbnail) needs to be regenerated. It is only
+     * meaningful for the same image instance.
+     */
+    quint64 generation() const;
+
+    /**
+     * @brief Brings @p pixmap up to date with the image, converting only the
+     * regions changed since the last call (see #dirtyRegion).
+     *
+     * If @p pixmap doesn't have the size of the image (e.g. it's null), it is
+     * recreated from the whole image instead, like by #qPix. Otherwise the
+     * dirty regions are drawn into it in place, which for small overlays on
+     * large frames is a fraction of the cost of converting the whole frame.
+     * @p pixmap is expected to be created by #qPix or by a previous call of
+     * this function on the same image. The dirty region is cleared afterwards.
+     * @return The region of @p pixmap that changed, e.g. for QWidget::update.
+     */
+    QRegion qPixUpdate(QPixmap& pixmap, Qt::ImageConversionFlags flags = Qt::AutoColor);
+
+    /**
+     * @brief Returns the region of the image changed since the last
+     * #qPixUpdate (or #clearDirty).
+     *
+     * Region-aware writes (the region overloads of #fill, #view and
+     * #markDirty) only mark the affected rectangle, all other modifications
+     * mark the whole image. Writes through the non-const #qImg, #cvMat,
+     * #scanLine and #rows accessors are only marked by #markDirty.
+     */
+    QRegion dirtyRegion() const;
+
+    /**
+     * @brief Marks @p rect as changed, see #dirtyRegion.
+     *
+     * Meant for data written without going through QCVimgCore, e.g. through
+     * the non-const #cvMat accessor, a QCVimgView or a cv::Mat ROI taken
+     * earlier. Besides extending the dirty region, it advances the
+     * #generation, and drops the cached hash and the device copy.
+     * @param rect Changed region, clipped to the image boundaries.
+     */
+    void markDirty(const QRect& rect);
+
+    /**
+     * @brief Marks the whole image as changed, see the previous overload.
+     */
+    void markDirty();
+
+    /**
+     * @brief Clears the dirty region without updating any pixmap.
+     */
+    void clearDirty();
+
+    /**
+     * @brief Returns the color of a pixel in QColor format
+     * @param x column number of the pixel
+     * @param y row number of the pixel
+     * @return Pixel color in QColor format.
+     */
+    QColor pixelColor(int x, int y) const;
+
+    /**
+     * @brief Returns a pointer to the pixels of row @p y, interpreted as @p T.
+     *
+     * Unlike #pixelColor, no format dispatch or conversion is done, so this
+     * (together with #rows and #forEachPixel) is the way to write custom
+     * per-pixel algorithms. @p T must have the size of one pixel, see
+     * QCVimgPixel for types matching the compatible formats. Neither the type
+     * nor @p y are checked in release builds.
+     *
+     * The image is detached first (see #detach), the returned pointer is valid
+     * until the data is reallocated. To keep per-row access cheap, getting
+     * the pointer doesn't count as a modification, see #markDirty.
+     * @param y Row number, must satisfy 0 <= y < height.
+     */
+    template<typename T>
+    T* scanLine(int y);
+
+    /**
+     * @brief Returns a const pointer to the pixels of row @p y, see the
+     * previous overload.
+     */
+    template<typename T>
+    const T* scanLine(int y) const;
+
+    /**
+     * @brief Returns a range over all scanlines of the image, each of them a
+     * contiguous QCVimgSpan of @p T.
+     *
+     * The image is detached once, before the range is created. See #scanLine
+     * for the requirements on @p T, and for reporting the writes.
+     */
+    template<typename T>
+    QCVimgRows<T> rows();
+
+    /**
+     * @brief Returns a read-only range over all scanlines of the image, see the
+     * previous overload.
+     */
+    template<typename T>
+    QCVimgRows<const T> rows() const;
+
+    /**
+     * @brief Calls @p func on every pixel of the image.
+     *
+     * @p func is either called as func(T& pixel) or, if it accepts them, as
+     * func(T& pixel, int x, int y). Rows are processed according to @p
+     * execution; with PixelExecution::Parallel @p func is called from the
+     * threads of the current QCVimgExecution at once, so it must not modify shared state without
+     * synchronization. Continuous images are processed as a single long row.
+     * See #scanLine for the requirements on @p T. Counts as a modification
+     * of the whole image.
+     */
+    template<typename T, typename Func>
+    void forEachPixel(Func&& func, PixelExecution execution = PixelExecution::Sequential);
+
+    /**
+     * @brief Calls @p func on every pixel of the image without modifying it,
+     * see the previous overload (@p func gets a const T&).
+     */
+    template<typename T, typename Func>
+    void forEachPixel(Func&& func, PixelExecution execution = PixelExecution::Sequential) const;
+    /**
+     * @brief Rebinds the cv::Mat member to the QImage member data.
+     *
+     * This function can be called if the cv::Mat member somehow got out of sync
+     * from the QImage member, and QCVimgCore consistency needs to be regained by
+     * binding the Mat member to the QImage data. This is a relatively cheap
+     * operation, as no image data is reallocated or copied during the process.
+     * Compatible formats are checked before binding the cv::Mat format to the
+     * QImage member. See @p priority for more information.
+     * @param priority Determines what should be done in case of incompatible
+     * QImage format. If it is Hi, and the cv::Mat member could not be bound
+     * the QImage member because of an incompatible type, the data in the QImage
+     * member will remain unchanged and the cv::Mat member will be set to empty.
+     * If @p priority is low, and the cv::Mat member could not be bound the
+     * QImage member because of an incompatible type, both members will be set
+     * to an empty state.
+     * On compatible QImage formats @p priority has no effect. The default is Low.
+     * @return Returns 0 on successful binding of the cv::Mat member to the
+     * QImage data. -1 if incompatible QImage formats were found.
+     * See @p priority how these cases are handled.
+     */
+    int rebindMat(DataPrio priority = DataPrio::Low);
+
+    /**
+     * @brief Copies the data from the internal cv::Mat member into the QImage
+     * member, then binds the Mat member to it.
+     *
+     * This function is the opposite of #rebindMat, as this time the data in the
+     * cv::Mat member is used to restore QCVimgCore consistency. This is an expensive
+     * operation, as the data is first copied into a new QImage instance and the
+     * cv::Mat member is bound to it only after that. If the cv::Mat member is
+     * the only owner of its data (e.g. an OpenCV function reallocated it), the
+     * buffer is adopted instead, like by the cv::Mat&& constructor, and no copy
+     * is made. In BindingMode::Lazy the copy (or channel swap) is postponed
+     * until the data is first accessed, so the cv::Mat the data came from must
+     * not be modified in the meantime. The overall operation is
+     * almost identical to the cv::Mat overload of #copyFrom, but this time the
+     * source is the internal cv::Mat member. Compatible formats are checked
+     * before binding the format together. See @p priority for more information.
+     * @param priority Determines what should be done in case of incompatible
+     * QImage format. If it is Hi, and the data could not be copied over to
+     * QImage member because of an incompatible type, the data in the cv::Mat
+     * member will remain unchanged and the QImage member will be set to empty.
+     * If @p priority is low, and the data could not be copied over to QImage
+     * member because of an incompatible type, both members will be set to an
+     * empty state. On compatible QImage formats @p priority has no effect.
+     * The default is Low.
+     * @param matColorOrder
+     * @return On successful binding of the cv::Mat member to the QImage data
+     * it returns 0. If incompatible QImage formats were found, it returns -1.
+     * See @p priority how these cases are handled.
+     */
+    int rebindQImg(DataPrio priority = DataPrio::Low,
+                   MatColorOrder matColorOrder = MatColorOrder::RGB);
+
+    /**
+     * @brief Sets when data handed over by #rebindQImg (or the cv::Mat&&
+     * constructor) is copied or swizzled, see #BindingMode.
+     *
+     * Switching to BindingMode::Eager completes a postponed copy right away.
+     * Copies and moved images take over the mode.
+     */
+    void setBindingMode(BindingMode mode);
+
+    /**
+     * @brief Returns the binding mode of the image, see #setBindingMode.
+     */
+    BindingMode bindingMode() const;
+
+    /**
+     * @brief Resizes the image with the give new size
+     *
+     * This function directly calls the QImage::scaled() function on the QImage
+     * member, then creates a new QCVimgCore instance. See the Qt documentation for
+     * more information and parameter descriptions.
+     * @return A new QCVimgCore instance with the new size.
+     */
+    QCVimgCore resize(int width, int height,
+                      Qt::AspectRatioMode aspectRatioMode = Qt::IgnoreAspectRatio,
+                      Qt::TransformationMode transformMode = Qt::FastTransformation) const;
+
+    /**
+     * @brief Resizes the image with the given new size using OpenCV.
+     *
+     * Convenience overload of #resizeInto, which creates the destination image
+     * as well.
+     * @return A new QCVimgCore instance with the new size, or an empty image if
+     * resizing is not possible (see #resizeInto).
+     */
+    QCVimgCore resize(int width, int height, ResizeInterpolation interpolation,
+                      Qt::AspectRatioMode aspectRatioMode = Qt::IgnoreAspectRatio) const;
+
+    /**
+     * @brief Does the same as the OpenCV based #resize, but on a worker thread.
+     *
+     * See #convertToFormatAsync for how the data is shared with the worker.
+     * The current QCVimgExecution of the calling thread is used by the worker
+     * as well.
+     * @param pool The thread pool to run on, QThreadPool::globalInstance() if
+     * nullptr.
+     * @return A future of the resized image.
+     */
+    QFuture<QCVimgConstRef> resizeAsync(int width, int height,
+                                        ResizeInterpolation interpolation = ResizeInterpolation::Area,
+                                        Qt::AspectRatioMode aspectRatioMode = Qt::IgnoreAspectRatio,
+                                        QThreadPool* pool = nullptr) const;
+
+    /**
+     * @brief Resizes the image into an existing destination image.
+     *
+     * The image is resized by cv::resize, which writes the result directly into
+     * the cv::Mat member of @p dest and processes the destination rows in
+     * parallel (following OpenCV's own threading, see QCVimgExecution). If
+     * @p dest already has the resulting size and the same format as this
+     * image (and its data isn't shared with another QImage), its buffer is
+     * reused, so resizing every frame into the same destination doesn't require
+     * any allocation. Otherwise a new buffer is allocated for @p dest first.
+     * @param dest Destination image. Must not be the image itself.
+     * @param width Requested width of the result.
+     * @param height Requested height of the result.
+     * @param interpolation See #ResizeInterpolation for available methods.
+     * @param aspectRatioMode Determines how the requested size is adjusted, see
+     * QSize::scaled in the Qt documentation.
+     * @return 0 on success, -1 if the image is empty or its cv::Mat member
+     * isn't bound, if the resulting size is empty, or if @p dest is the image
+     * itself.
+     */
+    int resizeInto(QCVimgCore& dest, int width, int height,
+                   ResizeInterpolation interpolation = ResizeInterpolation::Area,
+                   Qt::AspectRatioMode aspectRatioMode = Qt::IgnoreAspectRatio) const;
+
+    /**
+     * @brief Creates an image pyramid of the image for multi-scale consumers.
+     *
+     * Unlike calling #resize for every scale, the levels are built once, each
+     * from the previous one, into a single allocation, and are rebuilt
+     * automatically after the image changes. The image has to outlive the
+     * pyramid, see QCVimgPyramid for details.
+     * @param levels Number of levels including the image itself.
+     * @param filter The filter used for downscaling.
+     * @return The pyramid, its levels are built on the first request.
+     */
+    QCVimgPyramid pyramid(int levels, PyramidFilter filter = PyramidFilter::Gaussian) const;
+
+    /**
+     * @brief Creates a shared, read-only handle to the image data.
+     *
+     * No image data is copied, the handle references the same buffer. Any
+     * later modification of this image through QCVimgCore detaches it from
+     * the buffer first, so the data seen through the handle never changes.
+     * @return A handle to the data, or an empty handle if the image is empty or
+     * its cv::Mat member isn't bound.
+     * @see QCVimgConstRef
+     */
+    QCVimgConstRef share() const;
+
+    /**
+     * @brief Saves the image into a file, see QImage::save.
+     * @param fileName The file to write.
+     * @param format Format of the file (e.g. "png"), deduced from the suffix
+     * of @p fileName if nullptr.
+     * @param quality Compression quality in the range of 0 to 100, or -1 for
+     * the default of the format.
+     * @return 0 on success, otherwise -1.
+     */
+    int save(const QString& fileName, const char* format = nullptr, int quality = -1) const;
+
+    /**
+     * @brief Tells if the image data is shared with another QImage.
+     *
+     * Copying the QImage member (e.g. through #qImg or #qPix) shares the data
+     * instead of copying it, and modifying the data of either image will then
+     * detach and copy it. Unlike #isMatBound, this check is a single reference
+     * count comparison.
+     * @return True if the data is shared, otherwise false.
+     */
+    bool shared() const;
+
+    /**
+     * @brief Swaps image with @p other
+     *
+     * Calls QImage's swap function, then swaps the cv::Mat members.
+     * @param other Image to swap the current one with.
+     */
+    void swap(QCVimgCore& other);
+
+    /**
+     * @brief Returns true if @p x and @p y coordinates define a valid coordinate
+     * within an image, otherwise false.
+     *
+     * Directly calls QImage's function with the same name.
+     * @param x column number of the pixel
+     * @param y row number of the pixel
+     */
+    bool valid(int x, int y) const;
+
+    /**
+     * @brief Returns a non-owning view of a rectangular region of the image.
+     *
+     * The QImage and cv::Mat members of the returned view both point directly
+     * into the data of this image (using the same stride), so no allocation or
+     * copy is performed, and any modification done through the view is visible
+     * in this image as well. The view is only valid as long as this image is
+     * alive and its data is not reallocated. See QCVimgView for details.
+     *
+     * The region of the view is marked dirty (see #dirtyRegion) when the view
+     * is created. Writes done through the view after a #qPixUpdate have to be
+     * marked again with #markDirty.
+     * @param rect Region of the image to create the view for. It is clipped
+     * to the image boundaries.
+     * @return A view of @p rect, or an empty view if @p rect doesn't intersect
+     * the image or the image has an incompatible format.
+     */
+    QCVimgView view(const QRect& rect);
+
+    /**
+     * @brief Returns the width of the image.
+     * @return Width of the image.
+     */
+    int width() const;
+
+    /**
+     * @brief Serializes the image into @p ds using the given encoding.
+     *
+     * The raw encoding consists of a 32 byte header (magic number, version,
+     * header size, QImage format, rows, columns, cv::Mat type and stride,
+     * padded with zeros) followed by the scanlines as they are stored in
+     * memory. The PNG encoding is compatible with the
+     * data written by earlier versions of QCVimg. Both can be read back with
+     * operator>>.
+     * @param ds Stream to write to.
+     * @param encoding Encoding to use, see #StreamEncoding.
+     * @return 0 on success, -1 if the status of @p ds isn't QDataStream::Ok
+     * after writing.
+     */
+    int writeTo(QDataStream& ds, StreamEncoding encoding = StreamEncoding::Raw) const;
+
+    /**
+     * @brief Converts a QImage format to a compatible cv::Mat format.
+     *
+     * In case an invalid format is provided, -1 is returned to indicate error.
+     * DETAILS ABOUT VALID FORMATS
+     *
+     * @param qFormat A QImage::Format type format. See Qt documentation for more
+     * information.
+     * @return A format used for cv::Mat. See OpenCV documentation for more
+     * information.
+     */
+    static constexpr int convertQImgFormatTag(QImage::Format qFormat)
+    {
+        return (qFormat >= 0 && qFormat < QImage::NImageFormats) ?
+                    QCVimgFormatTable::scQtToCv[qFormat] : -1;
+    }
+
+    /**
+     * @brief Converts cv::Mat format to a compatible QImage format.
+     *
+     * In case an invalid format is provided, QImage::Format_Invalid is returned.
+     * DETAILS ABOUT VALID FORMATS
+     *
+     * @param matFormat A format used for cv::Mat. See OpenCV documentation for
+     * more information.
+     * @return A QImage::Format type format. See Qt documentation for more
+     * information.
+     */
+    static constexpr QImage::Format convertMatFormatTag(int matFormat)
+    {
+        return (matFormat >= 0 && matFormat < QCVimgFormatTable::scMatFormatCount) ?
+                    QCVimgFormatTable::scCvToQt[matFormat] : QImage::Format_Invalid;
+    }
+
+    /**
+     * @brief A convenience function to check if provided image format is an
+     * acceptable format.
+     * @param qFormat A QImage::Format type format. See Qt documentation for
+     * more information.
+     * @return true if QCVimgCore can use provided format, otherwise false.
+     */
+    static constexpr bool isValidQImgFormat(QImage::Format qFormat)
+    {
+        return convertQImgFormatTag(qFormat) != -1;
+    }
+
+    /**
+     * @brief A convenience function to check if provided image format is an
+     * acceptable format.
+     * @param matFormat A format used for cv::Mat. See OpenCV documentation for
+     * more information.
+     * @return true if QCVimgCore can use provided format, otherwise false.
+     */
+    static constexpr bool isValidMatFormat(int matFormat)
+    {
+        return convertMatFormatTag(matFormat) != QImage::Format_Invalid;
+    }
+
+    /**
+     * @brief Swaps the red and blue channels in a three or four channel cv::Mat.
+     *
+     * This is a convenience function to help work with the default BGR color
+     * order of OpenCV images. For three channel (CV_8UC3) images it converts
+     * between RGB and BGR, for four channel (CV_8UC4) images between RGBA and
+     * BGRA (or RGBX and BGRX), the alpha channel is left untouched. Internally a
+     * dedicated SIMD shuffle kernel is used (selected at runtime depending on the
+     * CPU), large images are processed on the threads of the current
+     * QCVimgExecution.
+     *
+     * The swap can be done in place by passing the same image as @p sourceMat
+     * and @p destMat, or a @p destMat with matching size and type, which will be
+     * written without reallocation. This makes it safe to call on the internal
+     * cv::Mat member of QCVimgCore as well, as long as the member is provided as
+     * @p destMat in one of these ways.
+     * @param sourceMat Source image in which the red and blue channels need
+     * swapping. The data in it will remain unchanged, unless the swap is done
+     * in place.
+     * @param destMat Destination image with the result. See description for
+     * more info.
+     * @param sourceMatColorOrder Has no effect, since the swap is symmetric.
+     * Kept for compatibility.
+     * @return returns 0 if a three or four channel 8 bit image was provided,
+     * otherwise returns -1.
+     */
+    static int swapMatRedBlue(const cv::Mat& sourceMat, cv::Mat& destMat,
+                              MatColorOrder sourceMatColorOrder = MatColorOrder::RGB);
+
+    /**
+     * @brief Extracts red, green and blue channels of a QColor class instance
+     * and puts them into a cv::Scalar.
+     *
+     * This is a convenience function to help initialize cv::Mat images with a
+     * color.
+     * @param color A QColor instance.
+     * @param destScalarColorOrder Determines in what order the colors should
+     * be in the resulting cv::Scalar. See #MatColorOrder for available color
+     * orders.
+     * @return Extracted colors in a cv::Scalar format. The values are always
+     * of integer type.
+     */
+    static cv::Scalar convertQColorToScalar(const QColor& color, MatColorOrder destScalarColorOrder);
+
+    /**
+     * @brief Returns a list of human readable Qt image formats supprted by this
+     * class
+     */
+    static QStringList supportedQImgFormats();
+
+    /**
+     * @brief Converts the human readable Qt image format text to QImage::Format
+     * enum
+     * @return returns the appropriate QImage::Format if text is valid, otherwise
+     * returns QImage::Format_Invalid
+     */
+    static QImage::Format convertFormatTextToQImgFormat(const QString& formatText);
+
+    /**
+     * @brief Returns the number of detaches and deep copies done by all images
+     * since the start of the process (or the last #resetCopyStats call).
+     *
+     * Meant for finding redundant copies while profiling. The counters are
+     * updated atomically, so they can be used from any thread.
+     *
+     * These counters are always collected, and only count. Every operation
+     * counted here is recorded by #stats too (when it is compiled in), where
+     * both detaches and deep copies add to QCVimgStats::Snapshot::deepCopies,
+     * together with the copies out of an image (#copyTo, #upload and device
+     * downloads). Use these counters to check for redundant copies in any
+     * build, and #stats for the byte totals and timings.
+     */
+    static CopyStats copyStats();
+
+    /**
+     * @brief Sets all counters returned by #copyStats to zero.
+     */
+    static void resetCopyStats();
+
+    /**
+     * @brief Returns the allocations, deep copies, swizzles, conversions and
+     * rebinds done by all threads, with their byte totals and timings.
+     *
+     * Unlike #copyStats, the counters are only collected if the library was
+     * built with QCVIMG_ENABLE_STATS, otherwise they all read zero. Their
+     * deep copy counter is a superset of both #copyStats counters. To reset
+     * them, enable the timers or install a callback, see QCVimgStats.
+     */
+    static QCVimgStats::Snapshot stats();
+
+    /**
+     * @brief Creates an image on top of a memory mapped file containing raw
+     * serialized data (see #writeTo).
+     *
+     * Both the QImage and cv::Mat members point directly into the mapping, so
+     * pages are only loaded as they are accessed. The file stays mapped as long
+     * as the returned image (or any QImage sharing its data) exists. By default
+     * the mapping is private: the image can be modified, but the changes are
+     * never written back to the file. If @p mode contains QIODevice::WriteOnly,
+     * the file is opened for writing and modifications of the image data are
+     * written back.
+     * @param fileName File containing a single raw serialized image.
+     * @param mode Tells whether changes should be written back to the file.
+     * @return The mapped image, or an empty image if the file can't be mapped
+     * or doesn't contain a valid raw serialized image.
+     */
+    static QCVimgCore mapFile(const QString& fileName, QIODevice::OpenMode mode = QIODevice::ReadOnly);
+
+    /**
+     * @brief Creates an image on top of a shared memory segment containing raw
+     * serialized data.
+     *
+     * The image points directly into the segment, which allows zero-copy
+     * handoff of frames between processes. @p sharedMemory must already be
+     * attached, and must stay attached as long as the returned image exists.
+     * Synchronizing access (e.g. with QSharedMemory::lock) is up to the caller.
+     * @return The image in shared memory, or an empty image if the segment
+     * isn't attached or doesn't contain a valid raw serialized image.
+     * @see rawSize
+     */
+    static QCVimgCore fromSharedMemory(QSharedMemory& sharedMemory);
+
+    /**
+     * @brief Initializes a shared memory segment for an image of the given size
+     * and format, and creates an image on top of it.
+     *
+     * The raw header is written at the beginning of @p sharedMemory, so the
+     * segment can be opened with the previous overload in another process. The
+     * image data itself is left uninitialized.
+     * @return The image in shared memory, or an empty image if the segment
+     * isn't attached, the format is incompatible or the segment is smaller than
+     * #rawSize.
+     */
+    static QCVimgCore fromSharedMemory(QSharedMemory& sharedMemory, int width, int height, QImage::Format format);
+
+    /**
+     * @brief Returns the number of bytes needed to store an image of the given
+     * size and format in the raw serialization format.
+     * @return Size including the header, or -1 for incompatible formats or
+     * empty sizes.
+     */
+    static qsizetype rawSize(int width, int height, QImage::Format format);
+
+protected:
+    /**
+     * @brief Constructs an image without checking the format.
+     *
+     * Used by QCVimgT, where the compatibility of the format is already
+     * guaranteed at compile time.
+     */
+    QCVimgCore(int width, int height, QImage::Format format, MatFormat matFormat);
+
+private:
+    friend class QCVimgPipeline;
+    friend class QCVimgReader;
+    friend class QCVimgStore;
+
+    QImage mQImg;
+    cv::Mat mMImg;
+    mutable cv::UMat mUMat;
+    mutable cv::Mat mPendingMat;
+    mutable size_t mCachedHash = 0;
+    mutable bool mHashCached = false;
+    mutable bool mDeviceDirty = false;
+    mutable bool mPendingRedBlueSwap = false;
+    BindingMode mBindingMode = BindingMode::Eager;
+    QRegion mDirtyRegion;
+    quint64 mGeneration = 0;
+    mutable QPixmap mCachedPix;
+    mutable quint64 mCachedPixGeneration = 0;
+    mutable Qt::ImageConversionFlags mCachedPixFlags;
+    static const QMap<QString, QImage::Format> scmTextToQImgFormat;
+    static constexpr qint32 scmStreamMagic = 0x51435652; // "QCVR"
+    static constexpr quint16 scmStreamVersion = 1;
+    static constexpr quint16 scmStreamHeaderSize = 32;
+
+    static QMap<QString, QImage::Format> fillQImgFormatToStringMap();
+
+    void createMatFromQImage(QImage& sourceQImg, cv::Mat& targetMat) const;
+    void createQImageFromMat(const cv::Mat& sourceMat, QImage& targetQImg, QImage::Format qFormat) const;
+    void copyFrom(const cv::Mat& sourceMat, QImage::Format qFormat);
+    void copyFrom(const QImage& sourceQImg);
+    void getRgbMat(const cv::Mat& sourceMat, cv::Mat& rgbMat, MatColorOrder sourceColorOrder) const;
+    static int convertInterpolation(ResizeInterpolation interpolation);
+    static bool isAdoptable(const cv::Mat& sourceMat);
+    static bool isExclusivelyOwned(const cv::Mat& sourceMat);
+    void adoptMat(cv::Mat&& sourceMat, QImage::Format qFormat);
+    static void releaseAdoptedMat(void* adoptedMat);
+    struct RawHeader
+    {
+        QImage::Format format = QImage::Format_Invalid;
+        int rows = 0, cols = 0, stride = 0, lineBytes = 0, headerSize = 0;
+    };
+
+    void writeRawTo(QDataStream& ds) const;
+    void readRawFrom(QDataStream& ds);
+    static void writeRawHeader(QDataStream& ds, QImage::Format format, int rows, int cols, int stride);
+    static int readRawHeader(QDataStream& ds, RawHeader& header);
+    static QCVimgCore fromRawData(uchar* data, qint64 size, QImageCleanupFunction cleanupFunction, void* cleanupInfo);
+    static void releaseMappedFile(void* mappedFile);
+    static QCVimgCore fromShared(const QCVimgConstRef& sharedImg);
+    void fillWithPixel(const QImage& pixelQImg, const QRect& rect);
+    void invalidateCaches();
+    void detachRegion(const QRect& rect);
+    const QImage& syncToHost() const;
+    void bindPendingData() const;
+    cv::UMat& deviceTarget();
+    void setMembersEmpty();
+    bool pointersMatch() const;
+    bool sizesMatch() const;
+    bool sizesMatch(const cv::Mat& first, const cv::Mat& second) const;
+    bool formatsMatch() const;
+    bool formatsMatch(const cv::Mat& first, const cv::Mat& second) const;
+    bool typesMatch(const cv::Mat& first, const cv::Mat& second) const;
+    bool matIsNull() const;
+
+    template<typename Pixel, typename Byte, typename Func>
+    static void forEachPixelIn(Byte* data, qsizetype stride, int width, int height,
+                               Func& func, PixelExecution execution);
+};
+
+template<typename T>
+T* QCVimgCore::scanLine(int y)
+{
+    Q_ASSERT(sizeof(T) == mMImg.elemSize() && y >= 0 && y < mMImg.rows);
+    detach();
+
+    return reinterpret_cast<T*>(mMImg.ptr(y));
+}
+
+template<typename T>
+const T* QCVimgCore::scanLine(int y) const
+{
+    Q_ASSERT(sizeof(T) == mMImg.elemSize() && y >= 0 && y < mMImg.rows);
+    syncToHost();
+
+    return reinterpret_cast<const T*>(mMImg.ptr(y));
+}
+
+template<typename T>
+QCVimgRows<T> QCVimgCore::rows()
+{
+    Q_ASSERT(mMImg.empty() || sizeof(T) == mMImg.elemSize());
+    detach();
+
+    return QCVimgRows<T>(mMImg.data, mMImg.step, mMImg.cols, mMImg.rows);
+}
+
+template<typename T>
+QCVimgRows<const T> QCVimgCore::rows() const
+{
+    Q_ASSERT(mMImg.empty() || sizeof(T) == mMImg.elemSize());
+    syncToHost();
+
+    return QCVimgRows<const T>(mMImg.data, mMImg.step, mMImg.cols, mMImg.rows);
+}
+
+template<typename T, typename Func>
+void QCVimgCore::forEachPixel(Func&& func, PixelExecution execution)
+{
+    if (mMImg.empty()) {
+        return;
+    }
+
+    Q_ASSERT(sizeof(T) == mMImg.elemSize());
+    detach();
+    invalidateCaches();
+
+    forEachPixelIn<T>(mMImg.data, mMImg.step, mMImg.cols, mMImg.rows, func, execution);
+}
+
+template<typename T, typename Func>
+void QCVimgCore::forEachPixel(Func&& func, PixelExecution execution) const
+{
+    if (mMImg.empty()) {
+        return;
+    }
+
+    Q_ASSERT(sizeof(T) == mMImg.elemSize());
+    syncToHost();
+
+    forEachPixelIn<const T>(static_cast<const uchar*>(mMImg.data), mMImg.step, mMImg.cols, mMImg.rows,
+                            func, execution);
+}
+
+template<typename Pixel, typename Byte, typename Func>
+void QCVimgCore::forEachPixelIn(Byte* data, qsizetype stride, int width, int height,
+                                Func& func, PixelExecution execution)
+{
+    constexpr bool withCoordinates = std::is_invocable<Func&, Pixel&, int, int>::value;
+
+    // Without coordinates the rows of a continuous image can be processed as
+    // one, which keeps the inner loop going over the whole buffer. Parallel
+    // processing needs the rows to split them between threads.
+    if (!withCoordinates && execution == PixelExecution::Sequential
+            && stride == qsizetype(width) * qsizetype(sizeof(Pixel))
+            && qint64(width) * height <= std::numeric_limits<int>::max()) {
+        width *= height;
+        stride *= height;
+        height = 1;
+    }
+
+    auto processRows = [&](int firstRow, int lastRow) {
+        for (int y = firstRow; y < lastRow; ++y) {
+            Pixel* line = reinterpret_cast<Pixel*>(data + stride * y);
+
+            for (int x = 0; x < width; ++x) {
+                if constexpr (withCoordinates) {
+                    func(line[x], x, y);
+                } else {
+                    func(line[x]);
+                }
+            }
+        }
+    };
+
+    if (execution == PixelExecution::Parallel && height > 1) {
+        QCVimgExecution::current().parallelFor(cv::Range(0, height), [&](const cv::Range& range) {
+            processRows(range.start, range.end);
+        });
+    } else {
+        processRows(0, height);
+    }
+}
+
+#endif // QCVIMGCORE_H
@@ -0,0 +1,120 @@
+﻿#include "qcvimgexecution.h"
+
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent/QtConcurrentRun>
+#include <opencv2/core/utility.hpp>
+
+#include <algorithm>
+
+
+namespace {
+
+thread_local QCVimgExecution tExecution;
+
+void runSerially(const std::function<void(const cv::Range&)>& body, const cv::Range& range)
+{
+    QCVimgExecution::Scope scope(QCVimgExecution::serial());
+    body(range);
+}
+
+cv::Range stripe(const cv::Range& range, int index, int stripes)
+{
+    const qint64 size = range.size();
+
+    return cv::Range(range.start + static_cast<int>(size * index / stripes),
+                     range.start + static_cast<int>(size * (index + 1) / stripes));
+}
+
+} // namespace
+
+
+QCVimgExecution::QCVimgExecution(int maxThreads, QThreadPool* pool)
+    : mMaxThreads(maxThreads), mPool(pool) {}
+
+QCVimgExecution QCVimgExecution::serial()
+{
+    return QCVimgExecution(1, nullptr);
+}
+
+QCVimgExecution QCVimgExecution::threads(int maxThreads)
+{
+    return QCVimgExecution(std::max(maxThreads, 1), nullptr);
+}
+
+QCVimgExecution QCVimgExecution::onPool(QThreadPool* pool, int maxThreads)
+{
+    return QCVimgExecution(std::max(maxThreads, 0), pool);
+}
+
+QCVimgExecution QCVimgExecution::current()
+{
+    return tExecution;
+}
+
+int QCVimgExecution::maxThreads() const
+{
+    return mMaxThreads;
+}
+
+QThreadPool* QCVimgExecution::threadPool() const
+{
+    return mPool;
+}
+
+bool QCVimgExecution::isDefault() const
+{
+    return mMaxThreads == 0 && mPool == nullptr;
+}
+
+void QCVimgExecution::parallelFor(const cv::Range& range, const std::function<void(const cv::Range&)>& body) const
+{
+    if (range.empty()) {
+        return;
+    }
+
+    if (mMaxThreads == 1 || range.size() == 1) {
+        runSerially(body, range);
+        return;
+    }
+
+    auto serialBody = [&body](const cv::Range& stripeRange) {
+        runSerially(body, stripeRange);
+    };
+
+    if (mPool == nullptr) {
+        // A stripe count limits how many of OpenCV's threads pick up work
+        cv::parallel_for_(range, serialBody, mMaxThreads > 0 ? mMaxThreads : -1.);
+        return;
+    }
+
+    const int threads = mMaxThreads > 0 ? mMaxThreads : mPool->maxThreadCount() + 1;
+    const int stripes = std::min(threads, range.size());
+    QVector<QFuture<void>> helpers;
+    helpers.reserve(stripes - 1);
+
+    for (int i = 1; i < stripes; ++i) {
+        helpers.append(QtConcurrent::run(mPool, [serialBody, range, i, stripes] {
+            serialBody(stripe(range, i, stripes));
+        }));
+    }
+
+    serialBody(stripe(range, 0, stripes));
+
+    // Stripes that haven't started yet are run by the waiting thread, so
+    // this doesn't deadlock when called from a thread of the same pool
+    for (auto& helper : helpers) {
+        helper.waitForFinished();
+    }
+}
+
+QCVimgExecution::Scope::Scope(const QCVimgExecution& execution)
+    : mPrevious(tExecution)
+{
+    tExecution = execution;
+}
+
+QCVimgExecution::Scope::~Scope()
+{
+    tExecution = mPrevious;
+}
@@ -0,0 +1,126 @@
+﻿#ifndef QCVIMGEXECUTION_H
+#define QCVIMGEXECUTION_H
+
+#include "qcvimglib_decl.h"
+
+#include <opencv4/opencv2/core/types.hpp>
+
+#include <functional>
+
+class QThreadPool;
+
+/**
+ * @brief Tells how many threads, and which ones, the bulk operations of
+ * QCVimg may use.
+ *
+ * By default the multithreaded operations (conversions, fills, red-blue swaps,
+ * parallel #QCVimgCore::forEachPixel and QCVimgBatch) split their rows with
+ * cv::parallel_for_, which uses all threads of OpenCV's pool. When several
+ * pipelines run side by side, that oversubscribes the cores. An execution
+ * context limits the number of threads used by a single operation, or moves
+ * the work onto a given QThreadPool instead:
+ * @code
+ * QCVimgExecution::Scope scope(QCVimgExecution::onPool(&mPipelinePool, 4));
+ * frame.convertInto(converted, QImage::Format_RGB32);
+ * @endcode
+ *
+ * The context is installed per thread with a #Scope, so it applies to every
+ * operation called from that thread while the scope is alive, without passing
+ * it around (QCVimgPipeline::setExecution installs it for its stages). The
+ * work done on the helper threads of an operation runs serially, so nested
+ * operations don't multiply the thread count.
+ *
+ * Functions doing their work in Qt or in a single OpenCV call can't be split
+ * this way: QImage based conversions and resizes, and cv::resize (used by the
+ * OpenCV based #QCVimgCore::resize) keep following Qt's and OpenCV's own
+ * threading. Copies are single threaded, so they stay within any context.
+ * Pinning threads to CPUs or NUMA nodes is left to the owner of the pool.
+ */
+class QCVIMGLIB_EXPORT QCVimgExecution
+{
+public:
+    /**
+     * @brief Creates the default context, using OpenCV's pool with its own
+     * thread count.
+     */
+    QCVimgExecution() = default;
+
+    /**
+     * @brief Returns a context running everything on the calling thread.
+     */
+    static QCVimgExecution serial();
+
+    /**
+     * @brief Returns a context using at most @p maxThreads threads of
+     * OpenCV's pool (including the calling thread).
+     * @param maxThreads Number of threads, 1 or less means serial execution.
+     */
+    static QCVimgExecution threads(int maxThreads);
+
+    /**
+     * @brief Returns a context running the work on @p pool.
+     *
+     * The calling thread takes part in the work as well, and waits for the
+     * rest of it to finish on @p pool.
+     * @param pool Pool to run on, must outlive every use of the context.
+     * @param maxThreads Maximum number of threads used by one operation, the
+     * maximum thread count of @p pool (plus the calling thread) if 0.
+     */
+    static QCVimgExecution onPool(QThreadPool* pool, int maxThreads = 0);
+
+    /**
+     * @brief Returns the context installed for the calling thread, the
+     * default context if none is.
+     */
+    static QCVimgExecution current();
+
+    /**
+     * @brief Returns the maximum number of threads used by one operation, 0
+     * if it's left to the pool.
+     */
+    int maxThreads() const;
+
+    /**
+     * @brief Returns the pool the work runs on, nullptr for OpenCV's pool.
+     */
+    QThreadPool* threadPool() const;
+
+    /**
+     * @brief Tells if this is the default context.
+     */
+    bool isDefault() const;
+
+    /**
+     * @brief Splits @p range into stripes and calls @p body on them, using
+     * the threads allowed by the context.
+     *
+     * @p body is called concurrently from several threads, with the context
+     * of those threads set to #serial.
+     */
+    void parallelFor(const cv::Range& range, const std::function<void(const cv::Range&)>& body) const;
+
+    /**
+     * @brief Installs a context for the calling thread for the lifetime of
+     * the scope, then restores the previous one.
+     */
+    class QCVIMGLIB_EXPORT Scope
+    {
+    public:
+        explicit Scope(const QCVimgExecution& execution);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        QCVimgExecution mPrevious;
+    };
+
+private:
+    QCVimgExecution(int maxThreads, QThreadPool* pool);
+
+    int mMaxThreads = 0;
+    QThreadPool* mPool = nullptr;
+};
+
+#endif // QCVIMGEXECUTION_H
@@ -0,0 +1,213 @@
+﻿#include "qcvimgfill.h"
+#include "qcvimgexecution.h"
+
+#include <opencv2/core/utility.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define QCVIMG_FILL_X86
+#  include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define QCVIMG_TARGET(isa) __attribute__((target(isa)))
+#else
+#  define QCVIMG_TARGET(isa)
+#endif
+
+
+namespace {
+
+using RowFillKernel = void (*)(uchar* dest, int bytes, const uchar* pattern);
+
+struct FillKernels
+{
+    RowFillKernel streaming;
+    const char* instructionSet;
+};
+
+// Multiple of every supported pixel size (1, 2, 3, 4, 6, 8, 12 and 16 bytes) and of the vector width
+const int scPatternPeriod = 192;
+// The pattern is extended by a vector width, so a full vector can be loaded at any phase
+const int scPatternBytes = scPatternPeriod + 32;
+
+// Below this many bytes splitting the work across threads costs more than it gains
+const qsizetype scParallelByteThreshold = 1 << 20;
+// Above this many bytes the filled buffer wouldn't fit into the cache anyway
+const qsizetype scStreamingByteThreshold = 1 << 23;
+
+void fillRowPlain(uchar* dest, int bytes, const uchar* pattern)
+{
+    int x = 0;
+
+    // Fixed size copies get compiled to wide vector stores
+    for (; x + scPatternPeriod <= bytes; x += scPatternPeriod) {
+        std::memcpy(dest + x, pattern, scPatternPeriod);
+    }
+
+    std::memcpy(dest + x, pattern, static_cast<size_t>(bytes - x));
+}
+
+#if defined(QCVIMG_FILL_X86)
+
+QCVIMG_TARGET("sse2")
+void fillRowStreamSse2(uchar* dest, int bytes, const uchar* pattern)
+{
+    // Streaming stores need an aligned destination
+    int x = std::min(bytes, static_cast<int>((16 - (reinterpret_cast<quintptr>(dest) & 15)) & 15));
+    std::memcpy(dest, pattern, static_cast<size_t>(x));
+    int phase = x;
+
+    for (; x + 16 <= bytes; x += 16) {
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dest + x),
+                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + phase)));
+        phase += 16;
+
+        if (phase >= scPatternPeriod) {
+            phase -= scPatternPeriod;
+        }
+    }
+
+    std::memcpy(dest + x, pattern + phase, static_cast<size_t>(bytes - x));
+}
+
+QCVIMG_TARGET("avx2")
+void fillRowStreamAvx2(uchar* dest, int bytes, const uchar* pattern)
+{
+    int x = std::min(bytes, static_cast<int>((32 - (reinterpret_cast<quintptr>(dest) & 31)) & 31));
+    std::memcpy(dest, pattern, static_cast<size_t>(x));
+    int phase = x;
+
+    for (; x + 32 <= bytes; x += 32) {
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dest + x),
+                            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pattern + phase)));
+        phase += 32;
+
+        if (phase >= scPatternPeriod) {
+            phase -= scPatternPeriod;
+        }
+    }
+
+    std::memcpy(dest + x, pattern + phase, static_cast<size_t>(bytes - x));
+}
+
+#endif
+
+FillKernels selectKernels()
+{
+#if defined(QCVIMG_FILL_X86)
+    if (cv::checkHardwareSupport(CV_CPU_AVX2)) {
+        return {fillRowStreamAvx2, "AVX2"};
+    } else if (cv::checkHardwareSupport(CV_CPU_SSE2)) {
+        return {fillRowStreamSse2, "SSE2"};
+    }
+#endif
+
+    return {fillRowPlain, "plain"};
+}
+
+const FillKernels& kernels()
+{
+    static const FillKernels selectedKernels = selectKernels();
+
+    return selectedKernels;
+}
+
+void finishStreaming()
+{
+#if defined(QCVIMG_FILL_X86)
+    // Streaming stores are weakly ordered, make them visible before returning
+    _mm_sfence();
+#endif
+}
+
+template<typename T>
+void packPixel(const cv::Scalar& value, int channels, uchar* pixel)
+{
+    for (int channel = 0; channel < channels; ++channel) {
+        const T channelValue = cv::saturate_cast<T>(value[channel]);
+        std::memcpy(pixel + channel * sizeof(T), &channelValue, sizeof(T));
+    }
+}
+
+}
+
+
+void QCVimgFill::fill(uchar* data, qsizetype bytesPerLine, int rows, int rowBytes, const uchar* pixel, int pixelBytes)
+{
+    if (data == nullptr || rows <= 0 || rowBytes <= 0 || pixelBytes <= 0 || pixelBytes > 16) {
+        return;
+    }
+
+    const qsizetype totalBytes = static_cast<qsizetype>(rowBytes) * rows;
+    const bool uniformBytes = std::all_of(pixel, pixel + pixelBytes, [pixel](uchar byte) {
+        return byte == pixel[0];
+    });
+    const bool streaming = !uniformBytes && totalBytes >= scStreamingByteThreshold;
+
+    uchar pattern[scPatternBytes];
+
+    for (int i = 0; i < scPatternBytes; ++i) {
+        pattern[i] = pixel[i % pixelBytes];
+    }
+
+    const RowFillKernel fillRow = streaming ? kernels().streaming : fillRowPlain;
+
+    auto fillRows = [&](const cv::Range& range) {
+        for (int row = range.start; row < range.end; ++row) {
+            uchar* rowData = data + bytesPerLine * row;
+
+            if (uniformBytes) {
+                std::memset(rowData, pixel[0], static_cast<size_t>(rowBytes));
+            } else {
+                fillRow(rowData, rowBytes, pattern);
+            }
+        }
+
+        if (streaming) {
+            finishStreaming();
+        }
+    };
+
+    if (totalBytes < scParallelByteThreshold) {
+        fillRows(cv::Range(0, rows));
+    } else {
+        QCVimgExecution::current().parallelFor(cv::Range(0, rows), fillRows);
+    }
+}
+
+int QCVimgFill::fill(cv::Mat& dest, const cv::Scalar& value)
+{
+    const int channels = dest.channels();
+    uchar pixel[16];
+
+    if (dest.dims != 2 || channels > 4) {
+        return -1;
+    }
+
+    switch (dest.depth()) {
+    case CV_8U:
+        packPixel<uchar>(value, channels, pixel);
+        break;
+    case CV_16U:
+        packPixel<ushort>(value, channels, pixel);
+        break;
+    case CV_32F:
+        packPixel<float>(value, channels, pixel);
+        break;
+    default:
+        return -1;
+    }
+
+    const int pixelBytes = static_cast<int>(dest.elemSize());
+    fill(dest.data, static_cast<qsizetype>(dest.step[0]), dest.rows, dest.cols * pixelBytes, pixel, pixelBytes);
+
+    return 0;
+}
+
+const char* QCVimgFill::activeInstructionSet()
+{
+    return kernels().instructionSet;
+}
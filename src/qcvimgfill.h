@@ -0,0 +1,49 @@
+﻿#ifndef QCVIMGFILL_H
+#define QCVIMGFILL_H
+
+#include <QtGlobal>
+#include <opencv4/opencv2/core/mat.hpp>
+
+/**
+ * @brief Fill kernels used internally by QCVimg.
+ *
+ * The kernels repeat the bytes of a single pixel over every row of a 2D
+ * buffer. The pixel is first expanded into a small pattern block, which is
+ * then written with wide vector stores. Large buffers are split into row
+ * bands processed on multiple threads, and buffers too large to stay in the
+ * cache are written with non-temporal (streaming) stores, so filling them
+ * doesn't evict the rest of the cache. Pixels consisting of identical bytes
+ * are written with memset.
+ *
+ * The best available implementation (AVX2 or SSE2 streaming stores, with a
+ * plain store fallback) is selected at runtime on first use, based on the
+ * CPU features reported by OpenCV.
+ */
+namespace QCVimgFill
+{
+    /**
+     * @brief Fills @p rows rows of @p rowBytes bytes with the pixel @p pixel.
+     * @param data Pointer to the first byte of the first row.
+     * @param bytesPerLine Distance between the start of two rows in bytes.
+     * @param pixel Bytes of a single pixel as they should appear in memory.
+     * @param pixelBytes Size of @p pixel, at most 16 bytes.
+     */
+    void fill(uchar* data, qsizetype bytesPerLine, int rows, int rowBytes, const uchar* pixel, int pixelBytes);
+
+    /**
+     * @brief Fills a 2D image with @p value.
+     *
+     * The channels of @p value are saturated to the depth of @p dest and
+     * written in the order they appear in @p value.
+     * @return 0 on success, -1 on an unsupported image type (the depth must
+     * be 8 or 16 bit unsigned, or 32 bit float).
+     */
+    int fill(cv::Mat& dest, const cv::Scalar& value);
+
+    /**
+     * @brief Returns the name of the instruction set the kernels run on.
+     */
+    const char* activeInstructionSet();
+}
+
+#endif // QCVIMGFILL_H
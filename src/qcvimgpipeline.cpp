@@ -0,0 +1,153 @@
+﻿#include "qcvimgpipeline.h"
+
+#include <QRunnable>
+#include <QThreadPool>
+
+
+namespace {
+
+class StageTask : public QRunnable
+{
+public:
+    explicit StageTask(std::function<void()> task)
+        : mTask(std::move(task)) {}
+
+    void run() override
+    {
+        mTask();
+    }
+
+private:
+    std::function<void()> mTask;
+};
+
+} // namespace
+
+
+QCVimgPipeline::QCVimgPipeline(QObject* parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<QCVimgConstRef>();
+}
+
+QCVimgPipeline::~QCVimgPipeline()
+{
+    waitForDone();
+}
+
+QCVimgPipeline& QCVimgPipeline::addStage(Stage stage)
+{
+    // A single thread per stage keeps the frames in order
+    auto executor = std::make_unique<QThreadPool>();
+    executor->setMaxThreadCount(1);
+
+    mStages.push_back(std::move(stage));
+    mExecutors.push_back(std::move(executor));
+
+    return *this;
+}
+
+QCVimgPipeline& QCVimgPipeline::swizzle()
+{
+    return addStage([](QCVimgCore& frame) {
+        if (frame.matFormat() == CV_8UC3 || frame.matFormat() == CV_8UC4) {
+            cv::Mat& mat = frame.cvMat();
+            QCVimgCore::swapMatRedBlue(mat, mat);
+            frame.markDirty();
+        }
+    });
+}
+
+QCVimgPipeline& QCVimgPipeline::convert(QImage::Format format)
+{
+    return addStage([format](QCVimgCore& frame) {
+        if (frame.qFormat() != format) {
+            frame = frame.convertToFormat(format);
+        }
+    });
+}
+
+QCVimgPipeline& QCVimgPipeline::resize(int width, int height, ResizeInterpolation interpolation, Qt::AspectRatioMode aspectRatioMode)
+{
+    return addStage([width, height, interpolation, aspectRatioMode](QCVimgCore& frame) {
+        frame = frame.resize(width, height, interpolation, aspectRatioMode);
+    });
+}
+
+QCVimgPipeline& QCVimgPipeline::pixmap()
+{
+    mEmitPixmaps = true;
+
+    return *this;
+}
+
+QCVimgPipeline& QCVimgPipeline::setExecution(const QCVimgExecution& execution)
+{
+    mExecution = execution;
+
+    return *this;
+}
+
+int QCVimgPipeline::stageCount() const
+{
+    return static_cast<int>(mStages.size());
+}
+
+QFuture<QCVimgConstRef> QCVimgPipeline::process(QCVimgCore&& frame)
+{
+    QFutureInterface<QCVimgConstRef> promise;
+    promise.reportStarted();
+    QFuture<QCVimgConstRef> future = promise.future();
+
+    runStage(0, std::make_shared<QCVimgCore>(std::move(frame)), promise);
+
+    return future;
+}
+
+QFuture<QCVimgConstRef> QCVimgPipeline::process(const QCVimgCore& frame)
+{
+    return process(QCVimgCore::fromShared(frame.share()));
+}
+
+void QCVimgPipeline::waitForDone()
+{
+    // Frames only move forward, so once a stage is drained, it stays drained
+    for (auto& executor : mExecutors) {
+        executor->waitForDone();
+    }
+}
+
+void QCVimgPipeline::runStage(size_t index, std::shared_ptr<QCVimgCore> frame, QFutureInterface<QCVimgConstRef> promise)
+{
+    if (index == mStages.size()) {
+        finishFrame(std::move(frame), std::move(promise));
+        return;
+    }
+
+    mExecutors[index]->start(new StageTask([this, index, frame, promise]() mutable {
+        {
+            QCVimgExecution::Scope scope(mExecution);
+            mStages[index](*frame);
+        }
+
+        runStage(index + 1, std::move(frame), std::move(promise));
+    }));
+}
+
+void QCVimgPipeline::finishFrame(std::shared_ptr<QCVimgCore> frame, QFutureInterface<QCVimgConstRef> promise)
+{
+    const QCVimgConstRef result = frame->share();
+    frame.reset();
+
+    promise.reportResult(result);
+    promise.reportFinished();
+
+    // Queued events of a destroyed pipeline are discarded
+    QMetaObject::invokeMethod(this, [this, result] {
+        emit frameReady(result);
+
+        if (mEmitPixmaps) {
+            emit pixmapReady(QPixmap::fromImage(result.qImg()));
+        }
+    }, Qt::QueuedConnection);
+}
@@ -0,0 +1,157 @@
+﻿#ifndef QCVIMGPIPELINE_H
+#define QCVIMGPIPELINE_H
+
+#include "qcvimglib_decl.h"
+#include "qcvimgcore.h"
+
+#include <QFuture>
+#include <QMetaType>
+#include <QObject>
+#include <QPixmap>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+class QThreadPool;
+
+/**
+ * @brief A chain of image processing stages running asynchronously, with the
+ * stages of consecutive frames overlapping.
+ *
+ * Every stage runs on its own dedicated worker thread, and frames pass from
+ * one stage to the next in the order they were submitted with #process. So
+ * while frame N is in the resize stage, frame N+1 can already be in the
+ * conversion stage, and the throughput is limited only by the slowest stage
+ * instead of the sum of all of them. The frames leave the pipeline in order.
+ *
+ * The common stages can be added with #swizzle, #convert and #resize, any
+ * other processing with #addStage, e.g.:
+ * @code
+ * pipeline.swizzle().convert(QImage::Format_RGB32).resize(640, 360).pixmap();
+ * connect(&pipeline, &QCVimgPipeline::pixmapReady, label, &QLabel::setPixmap);
+ * @endcode
+ *
+ * The stages have to be added before the first frame is processed. The
+ * pipeline itself must be used from the thread it lives in, the #frameReady
+ * and #pixmapReady signals are emitted in that thread too (which requires a
+ * running event loop). Destroying the pipeline waits for the frames still in
+ * it.
+ */
+class QCVIMGLIB_EXPORT QCVimgPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief A processing stage, which modifies the frame in place.
+     */
+    using Stage = std::function<void(QCVimgCore& frame)>;
+
+    /**
+     * @brief Creates an empty pipeline, which passes frames through unchanged.
+     */
+    explicit QCVimgPipeline(QObject* parent = nullptr);
+
+    /**
+     * @brief Waits for all frames in the pipeline, then destroys it.
+     */
+    ~QCVimgPipeline() override;
+
+    /**
+     * @brief Appends @p stage to the end of the pipeline.
+     * @return A reference to the pipeline, so calls can be chained.
+     */
+    QCVimgPipeline& addStage(Stage stage);
+
+    /**
+     * @brief Appends a stage swapping the red and blue channels of 8 bit, three
+     * or four channel frames (e.g. created from BGR cv::Mats without
+     * conversion), see QCVimgCore::swapMatRedBlue. Other frames are left as is.
+     * @return A reference to the pipeline, so calls can be chained.
+     */
+    QCVimgPipeline& swizzle();
+
+    /**
+     * @brief Appends a stage converting the frames into @p format, see
+     * QCVimgCore::convertToFormat.
+     * @return A reference to the pipeline, so calls can be chained.
+     */
+    QCVimgPipeline& convert(QImage::Format format);
+
+    /**
+     * @brief Appends a stage resizing the frames, see QCVimgCore::resize.
+     * @return A reference to the pipeline, so calls can be chained.
+     */
+    QCVimgPipeline& resize(int width, int height,
+                           ResizeInterpolation interpolation = ResizeInterpolation::Area,
+                           Qt::AspectRatioMode aspectRatioMode = Qt::IgnoreAspectRatio);
+
+    /**
+     * @brief Makes the pipeline emit #pixmapReady for every processed frame.
+     *
+     * QPixmaps can only be created in the GUI thread, so this is always the
+     * last step. Adding a #convert stage to the native pixmap format of the
+     * platform (usually QImage::Format_RGB32 or QImage::Format_ARGB32) before
+     * it keeps the work done in the GUI thread to a minimum.
+     * @return A reference to the pipeline, so calls can be chained.
+     */
+    QCVimgPipeline& pixmap();
+
+    /**
+     * @brief Sets the execution context the stages run with, see
+     * QCVimgExecution. By default the stages use the default context.
+     *
+     * Like the stages, the context has to be set before the first frame is
+     * processed.
+     * @return A reference to the pipeline, so calls can be chained.
+     */
+    QCVimgPipeline& setExecution(const QCVimgExecution& execution);
+
+    /**
+     * @brief Returns the number of stages in the pipeline.
+     */
+    int stageCount() const;
+
+    /**
+     * @brief Submits @p frame into the pipeline, without copying it.
+     * @return A future of the processed frame, see #frameReady.
+     */
+    QFuture<QCVimgConstRef> process(QCVimgCore&& frame);
+
+    /**
+     * @brief Submits a shared handle of @p frame into the pipeline, so it is
+     * only copied if a stage modifies it (see QCVimgCore::share).
+     * @return A future of the processed frame, see #frameReady.
+     */
+    QFuture<QCVimgConstRef> process(const QCVimgCore& frame);
+
+    /**
+     * @brief Blocks until all frames submitted so far left the pipeline.
+     */
+    void waitForDone();
+
+signals:
+    /**
+     * @brief Emitted for every frame leaving the pipeline, in order.
+     */
+    void frameReady(const QCVimgConstRef& frame);
+
+    /**
+     * @brief Emitted after #frameReady, if enabled with #pixmap.
+     */
+    void pixmapReady(const QPixmap& pixmap);
+
+private:
+    void runStage(size_t index, std::shared_ptr<QCVimgCore> frame, QFutureInterface<QCVimgConstRef> promise);
+    void finishFrame(std::shared_ptr<QCVimgCore> frame, QFutureInterface<QCVimgConstRef> promise);
+
+    std::vector<Stage> mStages;
+    std::vector<std::unique_ptr<QThreadPool>> mExecutors;
+    QCVimgExecution mExecution;
+    bool mEmitPixmaps = false;
+};
+
+Q_DECLARE_METATYPE(QCVimgConstRef)
+
+#endif // QCVIMGPIPELINE_H
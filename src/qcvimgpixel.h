@@ -0,0 +1,163 @@
+﻿#ifndef QCVIMGPIXEL_H
+#define QCVIMGPIXEL_H
+
+#include <QtGlobal>
+#include <QRgb>
+
+#include <iterator>
+#include <type_traits>
+
+/**
+ * @brief Pixel types matching the memory layout of the formats compatible with
+ * QCVimgCore, to be used with QCVimgCore::scanLine, QCVimgCore::rows and
+ * QCVimgCore::forEachPixel.
+ *
+ * Any trivially copyable type with the size of one pixel can be used instead
+ * (e.g. cv::Vec3b or QRgba64), these are provided for convenience.
+ */
+namespace QCVimgPixel
+{
+    /// Format_Grayscale8 and Format_Alpha8 pixels.
+    using Gray8 = uchar;
+    /// Format_Grayscale16 pixels.
+    using Gray16 = quint16;
+    /// Format_RGB32 and Format_ARGB32 pixels, see qRed, qGreen etc.
+    using ARGB32 = QRgb;
+
+    /// Format_RGB888 pixels.
+    struct RGB888
+    {
+        uchar r;
+        uchar g;
+        uchar b;
+    };
+
+    /// Format_BGR888 pixels.
+    struct BGR888
+    {
+        uchar b;
+        uchar g;
+        uchar r;
+    };
+
+    /// Format_RGBX8888 and Format_RGBA8888 pixels.
+    struct RGBA8888
+    {
+        uchar r;
+        uchar g;
+        uchar b;
+        uchar a;
+    };
+
+    /// Format_RGBX64 and Format_RGBA64 pixels.
+    struct RGBA64
+    {
+        quint16 r;
+        quint16 g;
+        quint16 b;
+        quint16 a;
+    };
+
+    /// Format_RGBX32FPx4 and Format_RGBA32FPx4 pixels.
+    struct RGBA32F
+    {
+        float r;
+        float g;
+        float b;
+        float a;
+    };
+
+    static_assert(sizeof(RGB888) == 3 && sizeof(BGR888) == 3, "unexpected padding in 24 bit pixel types");
+    static_assert(sizeof(RGBA8888) == 4 && sizeof(RGBA64) == 8 && sizeof(RGBA32F) == 16, "unexpected padding in pixel types");
+}
+
+/**
+ * @brief Tells how QCVimgCore::forEachPixel processes the rows of the image.
+ *
+ * Sequential processes the rows one after another on the calling thread,
+ * Parallel splits them between the threads of the current QCVimgExecution. Either way the
+ * pixels of a row are visited by a plain loop over contiguous memory, which
+ * the compiler is free to vectorize.
+ */
+enum class PixelExecution : uint8_t {Sequential, Parallel};
+
+/**
+ * @brief A non-owning, contiguous range of pixels (a scanline or a part of it).
+ *
+ * There are no bounds checks, it's simply a pointer and a size. Only valid as
+ * long as the image data it points into isn't reallocated.
+ */
+template<typename T>
+class QCVimgSpan
+{
+public:
+    QCVimgSpan() = default;
+    QCVimgSpan(T* data, int size)
+        : mData(data), mSize(size) {}
+
+    T* data() const { return mData; }
+    int size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+    T* begin() const { return mData; }
+    T* end() const { return mData + mSize; }
+    T& operator[](int index) const { return mData[index]; }
+
+private:
+    T* mData = nullptr;
+    int mSize = 0;
+};
+
+/**
+ * @brief A range over the scanlines of an image, each of them a QCVimgSpan.
+ * @see QCVimgCore::rows
+ */
+template<typename T>
+class QCVimgRows
+{
+    // Scanlines are addressed in bytes, as the stride isn't necessarily a
+    // multiple of the pixel size.
+    using Byte = std::conditional_t<std::is_const<T>::value, const uchar, uchar>;
+
+public:
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = QCVimgSpan<T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = QCVimgSpan<T>;
+
+        Iterator(Byte* line, qsizetype stride, int width)
+            : mLine(line), mStride(stride), mWidth(width) {}
+
+        QCVimgSpan<T> operator*() const { return QCVimgSpan<T>(reinterpret_cast<T*>(mLine), mWidth); }
+        Iterator& operator++() { mLine += mStride; return *this; }
+        Iterator operator++(int) { Iterator it = *this; mLine += mStride; return it; }
+        bool operator==(const Iterator& other) const { return mLine == other.mLine; }
+        bool operator!=(const Iterator& other) const { return mLine != other.mLine; }
+
+    private:
+        Byte* mLine;
+        qsizetype mStride;
+        int mWidth;
+    };
+
+    QCVimgRows() = default;
+    QCVimgRows(Byte* data, qsizetype stride, int width, int height)
+        : mData(data), mStride(stride), mWidth(width), mHeight(height) {}
+
+    Iterator begin() const { return Iterator(mData, mStride, mWidth); }
+    Iterator end() const { return Iterator(mData + mStride * mHeight, mStride, mWidth); }
+    int size() const { return mHeight; }
+    bool empty() const { return mHeight == 0; }
+    QCVimgSpan<T> operator[](int y) const { return QCVimgSpan<T>(reinterpret_cast<T*>(mData + mStride * y), mWidth); }
+
+private:
+    Byte* mData = nullptr;
+    qsizetype mStride = 0;
+    int mWidth = 0;
+    int mHeight = 0;
+};
+
+#endif // QCVIMGPIXEL_H
@@ -0,0 +1,143 @@
+﻿#include "qcvimgpool.h"
+
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+
+#include <tuple>
+
+
+namespace {
+
+struct BufferKey
+{
+    int width;
+    int height;
+    QImage::Format format;
+
+    bool operator<(const BufferKey& other) const
+    {
+        return std::tie(width, height, format) < std::tie(other.width, other.height, other.format);
+    }
+};
+
+}
+
+struct QCVimgPool::Private
+{
+    explicit Private(int maxCachedBuffersPerKey)
+        : maxCachedBuffersPerKey(maxCachedBuffersPerKey) {}
+
+    ~Private()
+    {
+        freeAll();
+    }
+
+    void freeAll()
+    {
+        for (const auto& buffers : qAsConst(freeBuffers)) {
+            for (auto buffer : buffers) {
+                qFreeAligned(buffer);
+            }
+        }
+
+        freeBuffers.clear();
+    }
+
+    mutable QMutex mutex;
+    QMap<BufferKey, QVector<uchar*>> freeBuffers;
+    const int maxCachedBuffersPerKey;
+};
+
+struct QCVimgPool::PooledBuffer
+{
+    std::weak_ptr<Private> pool;
+    BufferKey key;
+    uchar* data;
+};
+
+
+QCVimgPool::QCVimgPool(int maxCachedBuffersPerKey)
+    : mPrivate(std::make_shared<Private>(maxCachedBuffersPerKey))
+{
+}
+
+QCVimgPool::~QCVimgPool() = default;
+
+QCVimg QCVimgPool::acquire(int width, int height, QImage::Format format)
+{
+    if (!QCVimg::isValidQImgFormat(format) || width <= 0 || height <= 0) {
+        return QCVimg();
+    }
+
+    const int pixelBytes = QImage::toPixelFormat(format).bitsPerPixel() / 8;
+    const int bytesPerLine = (width * pixelBytes + scmBufferAlignment - 1) / scmBufferAlignment * scmBufferAlignment;
+    const BufferKey key{width, height, format};
+    uchar* data = nullptr;
+
+    {
+        QMutexLocker locker(&mPrivate->mutex);
+        auto it = mPrivate->freeBuffers.find(key);
+
+        if (it != mPrivate->freeBuffers.end() && !it->isEmpty()) {
+            data = it->takeLast();
+        }
+    }
+
+    if (data == nullptr) {
+        data = static_cast<uchar*>(qMallocAligned(static_cast<size_t>(bytesPerLine) * height,
+                                                  scmBufferAlignment));
+
+        if (data == nullptr) {
+            return QCVimg();
+        }
+    }
+
+    auto buffer = new PooledBuffer{mPrivate, key, data};
+    QImage pooledImg(data, width, height, bytesPerLine, format, releasePooledBuffer, buffer);
+
+    if (pooledImg.isNull()) {
+        // QImage doesn't call the cleanup function if it couldn't be created
+        releasePooledBuffer(buffer);
+        return QCVimg();
+    }
+
+    return QCVimg(std::move(pooledImg));
+}
+
+int QCVimgPool::cachedBuffers() const
+{
+    QMutexLocker locker(&mPrivate->mutex);
+    int count = 0;
+
+    for (const auto& buffers : qAsConst(mPrivate->freeBuffers)) {
+        count += buffers.size();
+    }
+
+    return count;
+}
+
+void QCVimgPool::clear()
+{
+    QMutexLocker locker(&mPrivate->mutex);
+    mPrivate->freeAll();
+}
+
+void QCVimgPool::releasePooledBuffer(void* pooledBuffer)
+{
+    auto buffer = static_cast<PooledBuffer*>(pooledBuffer);
+
+    if (auto pool = buffer->pool.lock()) {
+        QMutexLocker locker(&pool->mutex);
+        auto& buffers = pool->freeBuffers[buffer->key];
+
+        if (buffers.size() < pool->maxCachedBuffersPerKey) {
+            buffers.append(buffer->data);
+            buffer->data = nullptr;
+        }
+    }
+
+    qFreeAligned(buffer->data);
+    delete buffer;
+}
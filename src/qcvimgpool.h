@@ -0,0 +1,90 @@
+﻿#ifndef QCVIMGPOOL_H
+#define QCVIMGPOOL_H
+
+#include "qcvimglib_decl.h"
+#include "qcvimg.h"
+
+#include <memory>
+
+/**
+ * @brief A recycling allocator for QCVimg image buffers.
+ *
+ * Allocating and freeing large image buffers for every frame is expensive,
+ * not only because of the allocator itself, but because of the page faults
+ * that come with every freshly mapped buffer. QCVimgPool hands out QCVimg
+ * instances whose QImage member is constructed on top of a buffer owned by
+ * the pool. Once the last QImage referencing such a buffer is destroyed, the
+ * buffer is not freed but returned to the pool (through the QImage cleanup
+ * function), so the next request with the same width, height and format can
+ * reuse it without any allocation.
+ *
+ * All buffers are aligned to #scmBufferAlignment bytes, and so is the length
+ * of each scanline, which makes them friendly to vectorized code. Buffers are
+ * keyed by (width, height, format), and at most the number of buffers provided
+ * on construction are kept per key, the rest is freed immediately.
+ *
+ * The pool can be safely used from multiple threads. Images can outlive the
+ * pool they were acquired from, in which case their buffers are simply freed
+ * along with them.
+ *
+ * _IMPORTANT:_ Copying a pooled QCVimg creates a deep copy of the data in a
+ * regular (non-pooled) buffer, just like with any other QCVimg.
+ */
+class QCVIMGLIB_EXPORT QCVimgPool
+{
+public:
+    /**
+     * @brief Creates an empty pool.
+     * @param maxCachedBuffersPerKey Maximum number of unused buffers kept for
+     * each (width, height, format) combination.
+     */
+    explicit QCVimgPool(int maxCachedBuffersPerKey = 4);
+
+    /**
+     * @brief Frees all unused buffers.
+     *
+     * Buffers still in use are freed once their last user releases them.
+     */
+    ~QCVimgPool();
+
+    QCVimgPool(const QCVimgPool&) = delete;
+    QCVimgPool& operator=(const QCVimgPool&) = delete;
+
+    /**
+     * @brief Returns an image backed by a pooled buffer.
+     *
+     * If an unused buffer with matching size and format exists, it is reused,
+     * otherwise a new one is allocated. The image content is undefined, as with
+     * the respective QCVimg constructor. On an incompatible @p format or invalid
+     * size an empty image is returned.
+     * @param width Number of columns in a 2D image.
+     * @param height Number of rows in a 2D image.
+     * @param format In-memory format of image to be created. See
+     * QCVimg::isValidQImgFormat for valid formats.
+     */
+    QCVimg acquire(int width, int height, QImage::Format format);
+
+    /**
+     * @brief Returns the number of unused buffers currently held by the pool.
+     */
+    int cachedBuffers() const;
+
+    /**
+     * @brief Frees all unused buffers held by the pool.
+     */
+    void clear();
+
+    /**
+     * @brief Alignment of buffers and scanlines in bytes.
+     */
+    static const int scmBufferAlignment = 64;
+
+private:
+    struct Private;
+    struct PooledBuffer;
+    std::shared_ptr<Private> mPrivate;
+
+    static void releasePooledBuffer(void* pooledBuffer);
+};
+
+#endif // QCVIMGPOOL_H
@@ -0,0 +1,201 @@
+﻿#include "qcvimgpyramid.h"
+#include "qcvimgcore.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+
+
+namespace {
+
+// Cache line alignment for the start of every level
+constexpr size_t scLevelAlignment = 64;
+
+size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+QSize nextLevelSize(const QSize& size)
+{
+    return QSize((size.width() + 1) / 2, (size.height() + 1) / 2);
+}
+
+} // namespace
+
+
+QCVimgPyramid::QCVimgPyramid(const QCVimgCore& source, int levels, PyramidFilter filter)
+    : mSource(&source),
+      mRequestedLevels(std::max(levels, 1)),
+      mFilter(filter)
+{
+}
+
+QCVimgConstRef QCVimgPyramid::level(int index)
+{
+    if (mSource == nullptr || index < 0 || index >= levelCount()) {
+        return QCVimgConstRef();
+    }
+
+    if (index == 0) {
+        return mSource->share();
+    }
+
+    if (update() != 0) {
+        return QCVimgConstRef();
+    }
+
+    return mLevels[static_cast<size_t>(index - 1)];
+}
+
+int QCVimgPyramid::levelForScale(qreal scale) const
+{
+    int index = 0;
+    qreal levelScale = 0.5;
+
+    while (index + 1 < levelCount() && levelScale >= scale) {
+        ++index;
+        levelScale /= 2;
+    }
+
+    return index;
+}
+
+int QCVimgPyramid::levelCount() const
+{
+    if (mSource == nullptr || mSource->empty()) {
+        return 0;
+    }
+
+    QSize size(mSource->width(), mSource->height());
+    int count = 1;
+
+    while (count < mRequestedLevels && (size.width() > 1 || size.height() > 1)) {
+        size = nextLevelSize(size);
+        ++count;
+    }
+
+    return count;
+}
+
+QSize QCVimgPyramid::levelSize(int index) const
+{
+    if (index < 0 || index >= levelCount()) {
+        return QSize();
+    }
+
+    QSize size(mSource->width(), mSource->height());
+
+    for (int i = 0; i < index; ++i) {
+        size = nextLevelSize(size);
+    }
+
+    return size;
+}
+
+bool QCVimgPyramid::isStale() const
+{
+    return mSource != nullptr && (!mBuilt || mSource->generation() != mBuiltGeneration);
+}
+
+int QCVimgPyramid::update()
+{
+    if (mSource == nullptr || mSource->empty() || !mSource->isMatBound()) {
+        return -1;
+    }
+
+    if (!isStale()) {
+        return 0;
+    }
+
+    const cv::Mat& sourceMat = mSource->cvMat();
+    const int depth = sourceMat.depth();
+
+    // cv::pyrDown doesn't support the signed 8 bit and 16 bit float depths
+    if (mFilter == PyramidFilter::Gaussian && (depth == CV_8S || depth == CV_16F)) {
+        return -1;
+    }
+
+    if (allocateLevels() != 0) {
+        return -1;
+    }
+
+    QCVIMG_STATS_TIMER(Conversion);
+    const cv::Mat* previousMat = &sourceMat;
+
+    for (const QCVimgConstRef& levelRef : mLevels) {
+        // The handle is const only towards its users, the pyramid owns the buffer
+        cv::Mat levelMat = levelRef.cvMat();
+
+        if (mFilter == PyramidFilter::Gaussian) {
+            cv::pyrDown(*previousMat, levelMat, levelMat.size());
+        } else {
+            cv::resize(*previousMat, levelMat, levelMat.size(), 0, 0, cv::INTER_AREA);
+        }
+
+        QCVIMG_STATS_RECORD(Conversion, static_cast<qsizetype>(levelMat.step[0] * levelMat.rows));
+        previousMat = &levelRef.cvMat();
+    }
+
+    mBuiltGeneration = mSource->generation();
+    mBuilt = true;
+
+    return 0;
+}
+
+int QCVimgPyramid::allocateLevels()
+{
+    const QSize sourceSize(mSource->width(), mSource->height());
+    const QImage::Format format = mSource->qFormat();
+    const size_t levels = static_cast<size_t>(levelCount() - 1);
+
+    // The buffer can be written in place, unless a handed out level still references it
+    const bool reusable = sourceSize == mBuiltSize && format == mBuiltFormat && mLevels.size() == levels &&
+                          std::all_of(mLevels.cbegin(), mLevels.cend(), [](const QCVimgConstRef& levelRef) {
+                              return levelRef.qImg().isDetached();
+                          });
+
+    if (reusable) {
+        return 0;
+    }
+
+    const int matFormat = QCVimgCore::convertQImgFormatTag(format);
+    const size_t pixelBytes = CV_ELEM_SIZE(matFormat);
+    std::vector<QSize> sizes;
+    std::vector<size_t> offsets;
+    std::vector<size_t> strides;
+    size_t totalBytes = 0;
+    QSize size = sourceSize;
+
+    for (size_t i = 0; i < levels; ++i) {
+        size = nextLevelSize(size);
+        // QImage requires 32 bit aligned scanlines
+        const size_t stride = alignUp(pixelBytes * static_cast<size_t>(size.width()), 4);
+        sizes.push_back(size);
+        offsets.push_back(totalBytes);
+        strides.push_back(stride);
+        totalBytes = alignUp(totalBytes + stride * static_cast<size_t>(size.height()), scLevelAlignment);
+    }
+
+    mLevels.clear();
+    mBuffer = cv::Mat(1, static_cast<int>(totalBytes), CV_8UC1);
+    QCVIMG_STATS_RECORD(Allocation, static_cast<qsizetype>(totalBytes));
+
+    for (size_t i = 0; i < levels; ++i) {
+        // Every level keeps the buffer alive through its own Mat reference
+        QImage levelQImg(mBuffer.data + offsets[i], sizes[i].width(), sizes[i].height(),
+                         static_cast<int>(strides[i]), format, releaseBufferRef, new cv::Mat(mBuffer));
+        mLevels.push_back(QCVimgCore(std::move(levelQImg)).share());
+    }
+
+    mBuiltSize = sourceSize;
+    mBuiltFormat = format;
+    mBuilt = false;
+
+    return 0;
+}
+
+void QCVimgPyramid::releaseBufferRef(void* bufferRef)
+{
+    delete static_cast<cv::Mat*>(bufferRef);
+}
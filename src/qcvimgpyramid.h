@@ -0,0 +1,135 @@
+﻿#ifndef QCVIMGPYRAMID_H
+#define QCVIMGPYRAMID_H
+
+#include "qcvimglib_decl.h"
+#include "qcvimgconstref.h"
+
+#include <QImage>
+#include <QSize>
+#include <opencv4/opencv2/core/mat.hpp>
+
+#include <vector>
+
+class QCVimgCore;
+
+/**
+ * @brief Filters a QCVimgPyramid can build its levels with.
+ */
+enum class PyramidFilter : uint8_t {
+    /// 5x5 Gaussian kernel of cv::pyrDown, the usual choice for detectors.
+    Gaussian,
+    /// 2x2 box filter (averaging, cv::resize with INTER_AREA), cheaper and
+    /// sufficient for display purposes.
+    Box
+};
+
+/**
+ * @brief An image pyramid (mipmap chain) of a QCVimgCore, for consumers
+ * working on several scales of the same image.
+ *
+ * Level 0 is the source image itself, every further level is half the size of
+ * the previous one (rounded up), and is built from the previous level instead
+ * of the full resolution source. All levels above 0 are stored in a single
+ * allocation, and building the pyramid again for a source of the same size and
+ * format reuses it.
+ *
+ * The pyramid tracks the source by its generation (see
+ * QCVimgCore::generation): whenever the source is modified, the levels are
+ * rebuilt the next time one is requested. Levels are handed out as
+ * QCVimgConstRef handles into the pyramid buffer, which stay valid (and
+ * unchanged) even after the pyramid is rebuilt or destroyed, in that case the
+ * rebuild allocates a new buffer. Level 0 is a handle to the source itself,
+ * which costs a deep copy of the source if it is still held when the source is
+ * modified (see #level).
+ *
+ * _IMPORTANT:_ The pyramid references the source, which has to outlive it
+ * (and must not be moved from). The pyramid itself is not thread safe, but
+ * the handed out levels can be passed to other threads.
+ * @see QCVimgCore::pyramid
+ */
+class QCVIMGLIB_EXPORT QCVimgPyramid
+{
+public:
+    /**
+     * @brief Creates an empty pyramid without a source.
+     */
+    QCVimgPyramid() = default;
+
+    /**
+     * @brief Creates the pyramid of @p source.
+     *
+     * The levels are built on the first request, not by the constructor.
+     * @param source The image the pyramid is built from.
+     * @param levels Number of levels including the source. It is limited to
+     * the number of levels until the image shrinks to a single pixel.
+     * @param filter The filter used for downscaling.
+     */
+    QCVimgPyramid(const QCVimgCore& source, int levels, PyramidFilter filter = PyramidFilter::Gaussian);
+
+    /**
+     * @brief Returns the given level, rebuilding the pyramid first if the
+     * source changed since it was last built.
+     *
+     * Level 0 shares the data of the source (see QCVimgCore::share). As long
+     * as the returned handle (or a copy of it) is alive, the next
+     * modification of the source has to detach it, i.e. deep copy the whole
+     * source image. A producer updating the source every frame should
+     * therefore release the level 0 handle before the next update, or use the
+     * source directly instead of requesting level 0.
+     * @return The level, or an empty handle if @p index is out of range or
+     * the source is empty.
+     */
+    QCVimgConstRef level(int index);
+
+    /**
+     * @brief Returns the level best suited for displaying or processing the
+     * source at @p scale, i.e. the smallest level at least as large as the
+     * scaled source.
+     * @param scale Scaling factor relative to the source, e.g. 0.3.
+     * @return Index of the level, 0 for scales of 1 or more.
+     */
+    int levelForScale(qreal scale) const;
+
+    /**
+     * @brief Returns the number of levels including the source, or 0 if the
+     * source is empty.
+     */
+    int levelCount() const;
+
+    /**
+     * @brief Returns the size of the given level without building it, or an
+     * empty size if @p index is out of range.
+     */
+    QSize levelSize(int index) const;
+
+    /**
+     * @brief Tells if the levels have to be rebuilt because the source
+     * changed (or they weren't built at all yet).
+     */
+    bool isStale() const;
+
+    /**
+     * @brief Builds the levels if the pyramid is stale, otherwise does
+     * nothing.
+     * @return 0 on success, -1 if the source is empty or its format isn't
+     * supported by the filter.
+     */
+    int update();
+
+private:
+    int allocateLevels();
+
+    static void releaseBufferRef(void* bufferRef);
+
+    const QCVimgCore* mSource = nullptr;
+    int mRequestedLevels = 0;
+    PyramidFilter mFilter = PyramidFilter::Gaussian;
+    cv::Mat mBuffer;
+    std::vector<QCVimgConstRef> mLevels;
+    QSize mBuiltSize;
+    QImage::Format mBuiltFormat = QImage::Format_Invalid;
+    quint64 mBuiltGeneration = 0;
+    bool mBuilt = false;
+};
+
+#endif // QCVIMGPYRAMID_H
@@ -0,0 +1,106 @@
+﻿#include "qcvimgqueue.h"
+
+#include <algorithm>
+#include <cstddef>
+
+
+// The sequence tells which lap of the ring the slot is ready for: a producer
+// can fill it when it equals the push position, a consumer can empty it when
+// it equals the pop position + 1
+struct alignas(64) QCVimgQueue::Slot
+{
+    std::atomic<size_t> sequence{0};
+    QCVimgCore img;
+};
+
+QCVimgQueue::QCVimgQueue(int capacity)
+{
+    size_t slotCount = 2;
+
+    while (slotCount < static_cast<size_t>(std::max(capacity, 2))) {
+        slotCount *= 2;
+    }
+
+    mSlots.reset(new Slot[slotCount]);
+    mMask = slotCount - 1;
+
+    for (size_t i = 0; i < slotCount; ++i) {
+        mSlots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+QCVimgQueue::~QCVimgQueue() = default;
+
+bool QCVimgQueue::tryPush(QCVimgCore&& img)
+{
+    size_t position = mPushPosition.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    for (;;) {
+        slot = &mSlots[position & mMask];
+        const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const auto lap = static_cast<std::ptrdiff_t>(sequence - position);
+
+        if (lap == 0) {
+            if (mPushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (lap < 0) {
+            // The slot still holds the image of the previous lap
+            return false;
+        } else {
+            position = mPushPosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->img = std::move(img);
+    slot->sequence.store(position + 1, std::memory_order_release);
+
+    return true;
+}
+
+bool QCVimgQueue::tryPop(QCVimgCore& img)
+{
+    size_t position = mPopPosition.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    for (;;) {
+        slot = &mSlots[position & mMask];
+        const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const auto lap = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+
+        if (lap == 0) {
+            if (mPopPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (lap < 0) {
+            return false;
+        } else {
+            position = mPopPosition.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Moving leaves the slot empty, so the queue doesn't keep the data alive
+    img = std::move(slot->img);
+    slot->sequence.store(position + mMask + 1, std::memory_order_release);
+
+    return true;
+}
+
+int QCVimgQueue::capacity() const
+{
+    return static_cast<int>(mMask + 1);
+}
+
+int QCVimgQueue::size() const
+{
+    const size_t popPosition = mPopPosition.load(std::memory_order_acquire);
+    const size_t pushPosition = mPushPosition.load(std::memory_order_acquire);
+
+    return pushPosition > popPosition ? static_cast<int>(std::min(pushPosition - popPosition, mMask + 1)) : 0;
+}
+
+bool QCVimgQueue::empty() const
+{
+    return size() == 0;
+}
@@ -0,0 +1,86 @@
+﻿#ifndef QCVIMGQUEUE_H
+#define QCVIMGQUEUE_H
+
+#include "qcvimglib_decl.h"
+#include "qcvimgcore.h"
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief A bounded, lock-free queue handing images over between threads.
+ *
+ * Images are moved into and out of the queue, so passing a frame costs a
+ * few pointer assignments instead of copying it under a lock, and the
+ * receiving thread gets exclusive ownership. Any number of threads can push
+ * and pop concurrently, neither operation ever blocks: #tryPush fails if the
+ * queue is full, #tryPop if it is empty.
+ *
+ * The queue uses a ring of slots with a sequence counter each, so producers
+ * and consumers only contend on the slot they are claiming. The capacity is
+ * rounded up to the next power of two.
+ *
+ * _IMPORTANT:_ Pushed images shouldn't have other references to their data
+ * the sending thread keeps using (e.g. a QImage copy taken through
+ * QCVimgCore::qImg), see the thread safety notes of QCVimgCore.
+ * @see QCVimgTripleBuffer for handing over only the latest frame.
+ */
+class QCVIMGLIB_EXPORT QCVimgQueue
+{
+public:
+    /**
+     * @brief Creates an empty queue.
+     * @param capacity Minimum number of images the queue can hold.
+     */
+    explicit QCVimgQueue(int capacity);
+
+    ~QCVimgQueue();
+
+    QCVimgQueue(const QCVimgQueue&) = delete;
+    QCVimgQueue& operator=(const QCVimgQueue&) = delete;
+
+    /**
+     * @brief Moves @p img to the end of the queue.
+     * @return True on success, false if the queue is full, in which case
+     * @p img is left unchanged.
+     */
+    bool tryPush(QCVimgCore&& img);
+
+    /**
+     * @brief Moves the image at the front of the queue into @p img.
+     *
+     * The previous data of @p img is released, the queue doesn't keep it.
+     * @return True on success, false if the queue is empty, in which case
+     * @p img is left unchanged.
+     */
+    bool tryPop(QCVimgCore& img);
+
+    /**
+     * @brief Returns the number of images the queue can hold.
+     */
+    int capacity() const;
+
+    /**
+     * @brief Returns the number of images in the queue.
+     *
+     * With concurrent pushes or pops the result is only a snapshot, and might
+     * already be outdated when returned.
+     */
+    int size() const;
+
+    /**
+     * @brief Tells if the queue is empty, see #size.
+     */
+    bool empty() const;
+
+private:
+    struct Slot;
+
+    std::unique_ptr<Slot[]> mSlots;
+    size_t mMask;
+    // Separate cache lines keep producers and consumers from invalidating each other
+    alignas(64) std::atomic<size_t> mPushPosition{0};
+    alignas(64) std::atomic<size_t> mPopPosition{0};
+};
+
+#endif // QCVIMGQUEUE_H
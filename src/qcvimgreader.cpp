@@ -0,0 +1,95 @@
+﻿#include "qcvimgreader.h"
+#include "qcvimgpool.h"
+
+
+QCVimgReader::QCVimgReader(const QString& fileName, const QByteArray& format)
+    : mReader(fileName, format) {}
+
+QCVimgReader::QCVimgReader(QIODevice* device, const QByteArray& format)
+    : mReader(device, format) {}
+
+void QCVimgReader::setPool(QCVimgPool* pool)
+{
+    mPool = pool;
+}
+
+QImageReader& QCVimgReader::imageReader()
+{
+    return mReader;
+}
+
+QImage::Format QCVimgReader::imageFormat() const
+{
+    return mReader.imageFormat();
+}
+
+QSize QCVimgReader::size() const
+{
+    if (mReader.scaledSize().isValid()) {
+        return mReader.scaledSize();
+    } else if (mReader.clipRect().isValid()) {
+        return mReader.clipRect().size();
+    } else {
+        return mReader.size();
+    }
+}
+
+int QCVimgReader::read(QCVimgCore& dest)
+{
+    const QImage::Format format = imageFormat();
+    const QSize decodedSize = size();
+
+    // Only a buffer with the exact size and format of the decoded image is written in place by the plugins
+    if (QCVimgCore::isValidQImgFormat(format) && !decodedSize.isEmpty() &&
+        (dest.mQImg.size() != decodedSize || dest.mQImg.format() != format || !dest.mQImg.isDetached()))
+    {
+        if (mPool != nullptr) {
+            dest = static_cast<QCVimgCore&&>(mPool->acquire(decodedSize.width(), decodedSize.height(), format));
+        } else {
+            dest.mQImg = QImage(decodedSize, format);
+            QCVIMG_STATS_RECORD(Allocation, dest.mQImg.sizeInBytes());
+        }
+    }
+
+    dest.invalidateCaches();
+
+    if (!mReader.read(&dest.mQImg)) {
+        dest.setMembersEmpty();
+        return -1;
+    }
+
+    const QImage::Format targetFormat = compatibleFormat(dest.mQImg);
+
+    if (dest.mQImg.format() != targetFormat) {
+        QCVIMG_STATS_RECORD(Conversion, dest.mQImg.sizeInBytes());
+        dest.mQImg.convertTo(targetFormat);
+    }
+
+    dest.createMatFromQImage(dest.mQImg, dest.mMImg);
+
+    return 0;
+}
+
+QCVimg QCVimgReader::read()
+{
+    QCVimg img;
+    read(img);
+
+    return img;
+}
+
+QImage::Format QCVimgReader::compatibleFormat(const QImage& img)
+{
+    if (QCVimgCore::isValidQImgFormat(img.format())) {
+        return img.format();
+    } else if (img.depth() <= 8 && img.isGrayscale()) {
+        return QImage::Format_Grayscale8;
+    } else if (img.pixelFormat().redSize() > 8) {
+        // More than 8 bits per channel (e.g. RGB30), which the 16 bit formats keep
+        return img.hasAlphaChannel() ? QImage::Format_RGBA64 : QImage::Format_RGBX64;
+    } else if (img.hasAlphaChannel()) {
+        return QImage::Format_ARGB32;
+    } else {
+        return QImage::Format_RGB32;
+    }
+}
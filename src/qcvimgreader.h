@@ -0,0 +1,116 @@
+﻿#ifndef QCVIMGREADER_H
+#define QCVIMGREADER_H
+
+#include "qcvimglib_decl.h"
+#include "qcvimg.h"
+
+#include <QImageReader>
+
+class QCVimgPool;
+
+/**
+ * @brief Decodes images directly into the buffer of a QCVimgCore.
+ *
+ * The image is decoded by QImageReader (so every format supported by the Qt
+ * image plugins can be read), but instead of decoding into a new QImage and
+ * copying it into a QCVimg, the decoder writes straight into the buffer the
+ * cv::Mat member is bound to. If the destination image already has the size
+ * and format of the decoded image (e.g. while importing a batch of images of
+ * the same camera), its buffer is reused without any allocation, otherwise a
+ * buffer is taken from the pool set with #setPool (or allocated, if there is
+ * no pool).
+ *
+ * Decoded formats QCVimgCore can't work with (e.g. indexed or premultiplied
+ * images) are converted into the closest compatible format after decoding,
+ * which is the only case where the data is processed a second time.
+ *
+ * The options of the decoding (e.g. scaled size, clip rectangle, quality)
+ * can be set through #imageReader.
+ */
+class QCVIMGLIB_EXPORT QCVimgReader
+{
+public:
+    /**
+     * @brief Creates a reader without a source, see #imageReader.
+     */
+    QCVimgReader() = default;
+
+    /**
+     * @brief Creates a reader for the file @p fileName.
+     * @param format Format of the file (e.g. "png"), autodetected if empty.
+     */
+    explicit QCVimgReader(const QString& fileName, const QByteArray& format = QByteArray());
+
+    /**
+     * @brief Creates a reader for @p device, which must stay alive while the
+     * reader is used.
+     * @param format Format of the data (e.g. "png"), autodetected if empty.
+     */
+    explicit QCVimgReader(QIODevice* device, const QByteArray& format = QByteArray());
+
+    QCVimgReader(const QCVimgReader&) = delete;
+    QCVimgReader& operator=(const QCVimgReader&) = delete;
+
+    /**
+     * @brief Sets the pool new buffers are acquired from, or nullptr to
+     * allocate them normally. The pool must outlive the reader.
+     */
+    void setPool(QCVimgPool* pool);
+
+    /**
+     * @brief Returns the underlying QImageReader, for setting the source and
+     * the decoding options.
+     */
+    QImageReader& imageReader();
+
+    /**
+     * @brief Returns the format the next image will have after reading, or
+     * QImage::Format_Invalid if it can't be told without decoding.
+     */
+    QImage::Format imageFormat() const;
+
+    /**
+     * @brief Returns the size the next image will have after reading, taking
+     * the clip rectangle and scaled size into account, or an invalid size if it
+     * can't be told without decoding.
+     */
+    QSize size() const;
+
+    /**
+     * @brief Decodes the next image into @p dest.
+     *
+     * The buffer of @p dest is reused if it isn't shared and already has the
+     * size and format of the decoded image. Like with QImageReader::read,
+     * consecutive calls read the consecutive images of multi-image formats
+     * (e.g. animations).
+     * @return 0 on success, -1 if the image couldn't be read, in which case
+     * @p dest is left empty (see QImageReader::errorString for the reason).
+     */
+    int read(QCVimgCore& dest);
+
+    /**
+     * @brief Decodes the next image into a new (pooled) image.
+     * @return The decoded image, or an empty image on failure.
+     */
+    QCVimg read();
+
+    /**
+     * @brief Returns a QImage format compatible with QCVimgCore, which is the
+     * closest to the format of @p img.
+     *
+     * Grayscale images map to QImage::Format_Grayscale8 (or Grayscale16).
+     * Formats with more than 8 bits per channel (e.g.
+     * QImage::Format_RGBA64_Premultiplied or the 30 bit formats) map to
+     * QImage::Format_RGBA64 or Format_RGBX64, so no precision is lost, the
+     * rest to QImage::Format_ARGB32 or Format_RGB32. The alpha variant is
+     * chosen if the image has an alpha channel. Compatible formats are
+     * returned as is.
+     */
+    static QImage::Format compatibleFormat(const QImage& img);
+
+private:
+    QImageReader mReader;
+    QCVimgPool* mPool = nullptr;
+};
+
+#endif // QCVIMGREADER_H
@@ -0,0 +1,220 @@
+﻿#include "qcvimgstats.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+
+namespace {
+
+using AtomicCounters = std::array<std::atomic<quint64>, QCVimgStats::scEventCount>;
+using Totals = std::array<quint64, QCVimgStats::scEventCount>;
+
+struct ThreadCounters
+{
+    ThreadCounters();
+    ~ThreadCounters();
+
+    AtomicCounters counts {};
+    AtomicCounters bytes {};
+    AtomicCounters nanoseconds {};
+};
+
+// Counters of the running threads, and the sums of the finished ones
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<ThreadCounters*> threads;
+    Totals finishedCounts {};
+    Totals finishedBytes {};
+    Totals finishedNanoseconds {};
+};
+
+std::atomic<QCVimgStats::Hook> sHook{nullptr};
+std::atomic<bool> sTimersEnabled{false};
+
+Registry& registry()
+{
+    // Constructed on first use, so it outlives the counters of every thread
+    static Registry sRegistry;
+    return sRegistry;
+}
+
+ThreadCounters::ThreadCounters()
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.threads.push_back(this);
+}
+
+ThreadCounters::~ThreadCounters()
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    for (int event = 0; event < QCVimgStats::scEventCount; ++event) {
+        reg.finishedCounts[event] += counts[event].load(std::memory_order_relaxed);
+        reg.finishedBytes[event] += bytes[event].load(std::memory_order_relaxed);
+        reg.finishedNanoseconds[event] += nanoseconds[event].load(std::memory_order_relaxed);
+    }
+
+    reg.threads.erase(std::find(reg.threads.begin(), reg.threads.end(), this));
+}
+
+ThreadCounters& threadCounters()
+{
+    thread_local ThreadCounters tCounters;
+    return tCounters;
+}
+
+// Only the owning thread adds to its counters, but reset() zeroes them from
+// other threads, so the increment has to be atomic not to lose a reset. The
+// cache line is owned by the thread, so it stays uncontended.
+void add(std::atomic<quint64>& counter, quint64 value)
+{
+    counter.fetch_add(value, std::memory_order_relaxed);
+}
+
+QCVimgStats::Counter& counterOf(QCVimgStats::Snapshot& snapshot, int event)
+{
+    return const_cast<QCVimgStats::Counter&>(snapshot.counter(static_cast<QCVimgStats::Event>(event)));
+}
+
+void addThread(QCVimgStats::Snapshot& snapshot, const ThreadCounters& counters)
+{
+    for (int event = 0; event < QCVimgStats::scEventCount; ++event) {
+        QCVimgStats::Counter& counter = counterOf(snapshot, event);
+        counter.count += counters.counts[event].load(std::memory_order_relaxed);
+        counter.bytes += counters.bytes[event].load(std::memory_order_relaxed);
+        counter.nanoseconds += counters.nanoseconds[event].load(std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+
+const QCVimgStats::Counter& QCVimgStats::Snapshot::counter(Event event) const
+{
+    switch (event) {
+        case Event::Allocation:
+            return allocations;
+        case Event::DeepCopy:
+            return deepCopies;
+        case Event::Swizzle:
+            return swizzles;
+        case Event::Conversion:
+            return conversions;
+        case Event::Rebind:
+        default:
+            return rebinds;
+    }
+}
+
+bool QCVimgStats::enabled()
+{
+#if defined(QCVIMG_ENABLE_STATS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+QCVimgStats::Snapshot QCVimgStats::snapshot()
+{
+    Snapshot totals;
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    for (int event = 0; event < scEventCount; ++event) {
+        Counter& counter = counterOf(totals, event);
+        counter.count = reg.finishedCounts[event];
+        counter.bytes = reg.finishedBytes[event];
+        counter.nanoseconds = reg.finishedNanoseconds[event];
+    }
+
+    for (const ThreadCounters* counters : reg.threads) {
+        addThread(totals, *counters);
+    }
+
+    return totals;
+}
+
+QCVimgStats::Snapshot QCVimgStats::threadSnapshot()
+{
+    Snapshot totals;
+    addThread(totals, threadCounters());
+
+    return totals;
+}
+
+void QCVimgStats::reset()
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    reg.finishedCounts.fill(0);
+    reg.finishedBytes.fill(0);
+    reg.finishedNanoseconds.fill(0);
+
+    for (ThreadCounters* counters : reg.threads) {
+        for (int event = 0; event < scEventCount; ++event) {
+            counters->counts[event].store(0, std::memory_order_relaxed);
+            counters->bytes[event].store(0, std::memory_order_relaxed);
+            counters->nanoseconds[event].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void QCVimgStats::setHook(Hook hook)
+{
+    sHook.store(hook, std::memory_order_release);
+}
+
+void QCVimgStats::setTimersEnabled(bool enable)
+{
+    sTimersEnabled.store(enable, std::memory_order_relaxed);
+}
+
+bool QCVimgStats::timersEnabled()
+{
+    return sTimersEnabled.load(std::memory_order_relaxed);
+}
+
+void QCVimgStats::record(Event event, quint64 bytes)
+{
+    ThreadCounters& counters = threadCounters();
+    const auto index = static_cast<size_t>(event);
+    add(counters.counts[index], 1);
+    add(counters.bytes[index], bytes);
+
+    if (Hook hook = sHook.load(std::memory_order_acquire)) {
+        hook(event, bytes, 0);
+    }
+}
+
+void QCVimgStats::recordTime(Event event, quint64 nanoseconds)
+{
+    add(threadCounters().nanoseconds[static_cast<size_t>(event)], nanoseconds);
+
+    if (Hook hook = sHook.load(std::memory_order_acquire)) {
+        hook(event, 0, nanoseconds);
+    }
+}
+
+QCVimgStats::ScopedTimer::ScopedTimer(Event event)
+    : mEvent(event), mRunning(timersEnabled())
+{
+    if (mRunning) {
+        mStart = std::chrono::steady_clock::now();
+    }
+}
+
+QCVimgStats::ScopedTimer::~ScopedTimer()
+{
+    if (mRunning) {
+        const auto elapsed = std::chrono::steady_clock::now() - mStart;
+        recordTime(mEvent, static_cast<quint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+}
@@ -0,0 +1,161 @@
+﻿#ifndef QCVIMGSTATS_H
+#define QCVIMGSTATS_H
+
+#include "qcvimglib_decl.h"
+
+#include <QtGlobal>
+
+#include <chrono>
+
+/**
+ * @brief Opt-in instrumentation of the allocations, copies and conversions
+ * done by QCVimg.
+ *
+ * The instrumentation is compiled into the library only if it's built with
+ * QCVIMG_ENABLE_STATS defined (see QCVimgLib.pro). Otherwise the recording
+ * macros expand to nothing, so the counters cost nothing, and every snapshot
+ * reads zero.
+ *
+ * Every thread counts into its own set of atomic counters, so recording
+ * doesn't contend between threads. A #snapshot sums the counters of all
+ * threads (including the ones already finished), while #threadSnapshot only
+ * reads the calling thread. Timing the recorded operations has a cost of its
+ * own, so it is off until #setTimersEnabled is called.
+ */
+namespace QCVimgStats
+{
+    /**
+     * @brief Kinds of operations counted by the instrumentation.
+     */
+    enum class Event : uint8_t {Allocation, DeepCopy, Swizzle, Conversion, Rebind};
+
+    /// Number of Event values.
+    constexpr int scEventCount = 5;
+
+    /**
+     * @brief Totals of a single kind of operation.
+     */
+    struct Counter
+    {
+        /// Number of times the operation was done.
+        quint64 count = 0;
+        /// Number of image bytes the operation allocated or processed.
+        quint64 bytes = 0;
+        /// Time spent in the operation, only measured while timers are enabled.
+        quint64 nanoseconds = 0;
+    };
+
+    /**
+     * @brief Values of all counters at the time of taking the snapshot.
+     */
+    struct Snapshot
+    {
+        /// New image buffers allocated.
+        Counter allocations;
+        /// Image data copied, including detaching shared data.
+        Counter deepCopies;
+        /// Red and blue channels swapped between RGB and BGR order.
+        Counter swizzles;
+        /// Images converted into a different format.
+        Counter conversions;
+        /// Members rebound with #QCVimgCore::rebindMat or #QCVimgCore::rebindQImg.
+        Counter rebinds;
+
+        /**
+         * @brief Returns the counter of @p event.
+         */
+        const Counter& counter(Event event) const;
+    };
+
+    /**
+     * @brief Function called on every recorded operation.
+     *
+     * It is called synchronously on the thread doing the operation, so it has
+     * to be thread-safe and cheap. Operations are reported with @p nanoseconds
+     * set to 0, their measured time (if timers are enabled) is reported by a
+     * separate call with @p bytes set to 0.
+     */
+    using Hook = void (*)(Event event, quint64 bytes, quint64 nanoseconds);
+
+    /**
+     * @brief Returns true if the library was built with QCVIMG_ENABLE_STATS.
+     */
+    QCVIMGLIB_EXPORT bool enabled();
+
+    /**
+     * @brief Returns the sum of the counters of all threads.
+     */
+    QCVIMGLIB_EXPORT Snapshot snapshot();
+
+    /**
+     * @brief Returns the counters of the calling thread.
+     */
+    QCVIMGLIB_EXPORT Snapshot threadSnapshot();
+
+    /**
+     * @brief Sets the counters of all threads to zero.
+     *
+     * Every counter is reset atomically, so recording on other threads can't
+     * undo the reset. The counters of an operation recorded concurrently
+     * (e.g. its count and its bytes) might end up on different sides of the
+     * reset, though.
+     */
+    QCVIMGLIB_EXPORT void reset();
+
+    /**
+     * @brief Sets the function called on every recorded operation, or removes
+     * it if @p hook is nullptr.
+     */
+    QCVIMGLIB_EXPORT void setHook(Hook hook);
+
+    /**
+     * @brief Enables or disables measuring the time of the timed operations.
+     */
+    QCVIMGLIB_EXPORT void setTimersEnabled(bool enable);
+
+    /**
+     * @brief Returns true if the timed operations are measured.
+     */
+    QCVIMGLIB_EXPORT bool timersEnabled();
+
+    /**
+     * @brief Counts a single operation of @p bytes bytes.
+     */
+    QCVIMGLIB_EXPORT void record(Event event, quint64 bytes);
+
+    /**
+     * @brief Adds @p nanoseconds to the time spent in @p event operations.
+     */
+    QCVIMGLIB_EXPORT void recordTime(Event event, quint64 nanoseconds);
+
+    /**
+     * @brief Measures the time between its construction and destruction and
+     * records it for an event, if the timers are enabled.
+     */
+    class QCVIMGLIB_EXPORT ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Event event);
+        ~ScopedTimer();
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        std::chrono::steady_clock::time_point mStart;
+        Event mEvent;
+        bool mRunning;
+    };
+}
+
+#if defined(QCVIMG_ENABLE_STATS)
+#  define QCVIMG_STATS_RECORD(event, bytes) \
+    QCVimgStats::record(QCVimgStats::Event::event, static_cast<quint64>(bytes))
+#  define QCVIMG_STATS_TIMER(event) \
+    QCVimgStats::ScopedTimer qcvimgStatsTimer(QCVimgStats::Event::event)
+#else
+#  define QCVIMG_STATS_RECORD(event, bytes) do {} while (false)
+#  define QCVIMG_STATS_TIMER(event) do {} while (false)
+#endif
+
+#endif // QCVIMGSTATS_H
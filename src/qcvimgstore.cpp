@@ -0,0 +1,268 @@
+﻿#include "qcvimgstore.h"
+#include "qcvimgpool.h"
+
+#include <QDataStream>
+
+#include <algorithm>
+#include <limits>
+
+
+QCVimgStore::QCVimgStore(int capacity, int keyFrameInterval, int cachedFrames, QCVimgPool* pool)
+    : mOwnPool(pool == nullptr ? new QCVimgPool(std::max(cachedFrames, 1)) : nullptr),
+      mPool(pool != nullptr ? pool : mOwnPool.get()),
+      mCapacity(std::max(capacity, 0)),
+      mKeyFrameInterval(std::max(keyFrameInterval, 1)),
+      mCachedFrames(std::max(cachedFrames, 1))
+{
+}
+
+QCVimgStore::~QCVimgStore() = default;
+
+int QCVimgStore::append(const QCVimgCore& frame)
+{
+    if (frame.empty() || !frame.isMatBound()) {
+        return -1;
+    }
+
+    if (mCapacity > 0 && count() >= mCapacity) {
+        dropOldest();
+    }
+
+    QCVIMG_STATS_TIMER(Conversion);
+    const cv::Mat& frameMat = frame.cvMat();
+    const bool keyFrame = mFrames.empty() || mFramesSinceKeyFrame + 1 >= mKeyFrameInterval ||
+                          frame.qFormat() != mReferenceFormat || frameMat.size() != mReference.size();
+    Frame storedFrame;
+
+    // The reference is kept continuous, so it can be compressed without padding
+    if (keyFrame) {
+        frameMat.copyTo(mReference);
+    } else {
+        cv::bitwise_xor(frameMat, mReference, mScratch);
+        frameMat.copyTo(mReference);
+    }
+
+    mReferenceFormat = frame.qFormat();
+
+    if (encode(keyFrame ? mReference : mScratch, mReferenceFormat, keyFrame, storedFrame) != 0) {
+        // The next frame can't be a delta to a frame that isn't stored
+        mReference.release();
+        return -1;
+    }
+
+    mFramesSinceKeyFrame = keyFrame ? 0 : mFramesSinceKeyFrame + 1;
+    mCompressedBytes += storedFrame.data.size();
+    mUncompressedBytes += storedFrame.rawBytes;
+    mFrames.push_back(std::move(storedFrame));
+
+    return 0;
+}
+
+QCVimgConstRef QCVimgStore::frame(int index)
+{
+    if (index < 0 || index >= count()) {
+        return QCVimgConstRef();
+    }
+
+    const qint64 serial = mFirstSerial + index;
+    QCVimgConstRef decodedFrame = cachedFrame(serial);
+
+    if (!decodedFrame.empty()) {
+        return decodedFrame;
+    }
+
+    // Decoding starts at the closest cached frame or key frame before the requested one
+    qint64 first = serial;
+
+    while (first > mFirstSerial && !mFrames[static_cast<size_t>(first - mFirstSerial)].keyFrame) {
+        decodedFrame = cachedFrame(first - 1);
+
+        if (!decodedFrame.empty()) {
+            break;
+        }
+
+        --first;
+    }
+
+    for (qint64 current = first; current <= serial; ++current) {
+        decodedFrame = decode(current, decodedFrame);
+
+        if (decodedFrame.empty()) {
+            return QCVimgConstRef();
+        }
+
+        insertCached(current, decodedFrame);
+    }
+
+    return decodedFrame;
+}
+
+int QCVimgStore::count() const
+{
+    return static_cast<int>(mFrames.size());
+}
+
+int QCVimgStore::capacity() const
+{
+    return mCapacity;
+}
+
+void QCVimgStore::setCapacity(int capacity)
+{
+    mCapacity = std::max(capacity, 0);
+
+    while (mCapacity > 0 && count() > mCapacity) {
+        dropOldest();
+    }
+}
+
+int QCVimgStore::keyFrameInterval() const
+{
+    return mKeyFrameInterval;
+}
+
+void QCVimgStore::setCompressionLevel(int level)
+{
+    mCompressionLevel = qBound(0, level, 9);
+}
+
+qint64 QCVimgStore::compressedBytes() const
+{
+    return mCompressedBytes;
+}
+
+qint64 QCVimgStore::uncompressedBytes() const
+{
+    return mUncompressedBytes;
+}
+
+void QCVimgStore::clear()
+{
+    mFirstSerial += count();
+    mFrames.clear();
+    mCache.clear();
+    mReference.release();
+    mScratch.release();
+    mReferenceFormat = QImage::Format_Invalid;
+    mCompressedBytes = 0;
+    mUncompressedBytes = 0;
+    mFramesSinceKeyFrame = 0;
+}
+
+int QCVimgStore::encode(const cv::Mat& payloadMat, QImage::Format format, bool keyFrame, Frame& frame) const
+{
+    const qint64 lineBytes = static_cast<qint64>(payloadMat.cols) * static_cast<qint64>(payloadMat.elemSize());
+    const qint64 payloadBytes = lineBytes * payloadMat.rows;
+
+    if (!payloadMat.isContinuous() || payloadBytes > std::numeric_limits<int>::max()) {
+        return -1;
+    }
+
+    QDataStream headerStream(&frame.data, QIODevice::WriteOnly);
+    QCVimgCore::writeRawHeader(headerStream, format, payloadMat.rows, payloadMat.cols, static_cast<int>(lineBytes));
+    frame.data += qCompress(payloadMat.data, static_cast<int>(payloadBytes), mCompressionLevel);
+    QCVIMG_STATS_RECORD(Conversion, payloadBytes);
+    frame.rawBytes = payloadBytes;
+    frame.keyFrame = keyFrame;
+
+    return 0;
+}
+
+QCVimgConstRef QCVimgStore::decode(qint64 serial, const QCVimgConstRef& previous)
+{
+    const Frame& storedFrame = mFrames[static_cast<size_t>(serial - mFirstSerial)];
+    QDataStream headerStream(storedFrame.data);
+    qint32 magic = 0;
+    QCVimgCore::RawHeader header;
+
+    headerStream >> magic;
+
+    if (magic != QCVimgCore::scmStreamMagic || QCVimgCore::readRawHeader(headerStream, header) != 0 ||
+        header.rows <= 0 || storedFrame.data.size() < header.headerSize ||
+        (!storedFrame.keyFrame && (previous.empty() || previous.qFormat() != header.format ||
+                                   previous.width() != header.cols || previous.height() != header.rows)))
+    {
+        return QCVimgConstRef();
+    }
+
+    QCVIMG_STATS_TIMER(Conversion);
+    const QByteArray payload = qUncompress(reinterpret_cast<const uchar*>(storedFrame.data.constData()) + header.headerSize,
+                                           static_cast<int>(storedFrame.data.size() - header.headerSize));
+
+    if (payload.size() != static_cast<qint64>(header.stride) * header.rows) {
+        return QCVimgConstRef();
+    }
+
+    QCVimg decodedImg = mPool->acquire(header.cols, header.rows, header.format);
+    const int matFormat = QCVimgCore::convertQImgFormatTag(header.format);
+    const cv::Mat payloadMat(header.rows, header.cols, matFormat, const_cast<char*>(payload.constData()),
+                             static_cast<size_t>(header.stride));
+
+    // The scanlines are written straight into the pooled buffer, applying the delta on the way
+    if (storedFrame.keyFrame) {
+        payloadMat.copyTo(decodedImg.cvMat());
+    } else {
+        cv::bitwise_xor(payloadMat, previous.cvMat(), decodedImg.cvMat());
+    }
+
+    QCVIMG_STATS_RECORD(Conversion, payload.size());
+
+    return decodedImg.share();
+}
+
+QCVimgConstRef QCVimgStore::cachedFrame(qint64 serial)
+{
+    auto cached = std::find_if(mCache.begin(), mCache.end(), [serial](const std::pair<qint64, QCVimgConstRef>& entry) {
+        return entry.first == serial;
+    });
+
+    if (cached == mCache.end()) {
+        return QCVimgConstRef();
+    }
+
+    // Moving the entry to the front keeps the cache ordered by recent use
+    std::rotate(mCache.begin(), cached, cached + 1);
+
+    return mCache.front().second;
+}
+
+void QCVimgStore::insertCached(qint64 serial, const QCVimgConstRef& decodedFrame)
+{
+    if (static_cast<int>(mCache.size()) >= mCachedFrames) {
+        mCache.pop_back();
+    }
+
+    mCache.emplace(mCache.begin(), serial, decodedFrame);
+}
+
+void QCVimgStore::dropOldest()
+{
+    if (mFrames.empty()) {
+        return;
+    }
+
+    // The new oldest frame can't depend on the dropped one, so it becomes a key frame
+    if (mFrames.size() > 1 && !mFrames[1].keyFrame) {
+        const QCVimgConstRef nextFrame = frame(1);
+        cv::Mat payloadMat = nextFrame.cvMat().isContinuous() ? nextFrame.cvMat() : nextFrame.cvMat().clone();
+        Frame keyFrame;
+
+        if (!nextFrame.empty() && encode(payloadMat, nextFrame.qFormat(), true, keyFrame) == 0) {
+            mCompressedBytes += keyFrame.data.size() - mFrames[1].data.size();
+            mFrames[1] = std::move(keyFrame);
+        }
+    }
+
+    mCompressedBytes -= mFrames.front().data.size();
+    mUncompressedBytes -= mFrames.front().rawBytes;
+    mFrames.pop_front();
+    ++mFirstSerial;
+
+    mCache.erase(std::remove_if(mCache.begin(), mCache.end(), [this](const std::pair<qint64, QCVimgConstRef>& entry) {
+        return entry.first < mFirstSerial;
+    }), mCache.end());
+
+    if (mFrames.empty()) {
+        mReference.release();
+    }
+}
@@ -0,0 +1,155 @@
+﻿#ifndef QCVIMGSTORE_H
+#define QCVIMGSTORE_H
+
+#include "qcvimglib_decl.h"
+#include "qcvimgconstref.h"
+
+#include <QByteArray>
+#include <opencv4/opencv2/core/mat.hpp>
+
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class QCVimgCore;
+class QCVimgPool;
+
+/**
+ * @brief A compressed in-memory container of frames, e.g. for keeping a
+ * rolling buffer of recent frames for replay.
+ *
+ * Every frame is stored as a raw header (see QCVimgCore::writeTo) followed by
+ * its compressed scanlines. Key frames are compressed as they are, all other
+ * frames as the difference (XOR) to the previous frame, which is zero
+ * wherever the scene didn't change and therefore compresses much better.
+ * A key frame is stored every #keyFrameInterval frames, and whenever the size
+ * or format of the frames changes.
+ *
+ * Frames are decompressed on access into pooled buffers (see QCVimgPool), and
+ * the most recently accessed ones are kept in a small LRU cache, so
+ * sequential replay only decodes a single frame per access. Accessing frame
+ * @c n randomly decodes at most the frames since the last key frame before
+ * it.
+ *
+ * If a capacity is set, appending to a full store drops the oldest frame. A
+ * delta frame becoming the oldest one is converted to a key frame.
+ *
+ * _IMPORTANT:_ The store is not thread safe, but the handed out frames can be
+ * passed to other threads.
+ */
+class QCVIMGLIB_EXPORT QCVimgStore
+{
+public:
+    /**
+     * @brief Creates an empty store.
+     * @param capacity Maximum number of frames, or 0 for no limit.
+     * @param keyFrameInterval Number of frames between key frames, 1 stores
+     * every frame as a key frame.
+     * @param cachedFrames Number of decoded frames kept in the cache.
+     * @param pool Pool for the decoded frames, the store uses its own if
+     * nullptr. An external pool has to outlive the store.
+     */
+    explicit QCVimgStore(int capacity = 0, int keyFrameInterval = 30, int cachedFrames = 4,
+                         QCVimgPool* pool = nullptr);
+
+    /**
+     * @brief Destroys the store, decoded frames handed out stay valid.
+     */
+    ~QCVimgStore();
+
+    QCVimgStore(const QCVimgStore&) = delete;
+    QCVimgStore& operator=(const QCVimgStore&) = delete;
+
+    /**
+     * @brief Compresses @p frame and appends it to the store.
+     * @return 0 on success, -1 if the frame is empty, its cv::Mat member isn't
+     * bound, or it is too large to be compressed at once (2 GiB).
+     */
+    int append(const QCVimgCore& frame);
+
+    /**
+     * @brief Returns the frame at @p index, decoding it if it isn't cached.
+     * @param index Index of the frame, 0 being the oldest one in the store.
+     * @return The frame, or an empty handle if @p index is out of range or
+     * the data can't be decoded.
+     */
+    QCVimgConstRef frame(int index);
+
+    /**
+     * @brief Returns the number of frames in the store.
+     */
+    int count() const;
+
+    /**
+     * @brief Returns the maximum number of frames, 0 if unlimited.
+     */
+    int capacity() const;
+
+    /**
+     * @brief Sets the maximum number of frames, dropping the oldest ones if
+     * there are more than @p capacity.
+     * @param capacity Maximum number of frames, or 0 for no limit.
+     */
+    void setCapacity(int capacity);
+
+    /**
+     * @brief Returns the number of frames between key frames.
+     */
+    int keyFrameInterval() const;
+
+    /**
+     * @brief Sets the compression level passed to qCompress, from 0 (no
+     * compression) to 9. The default of 1 favors speed, higher levels only
+     * apply to frames appended afterwards.
+     */
+    void setCompressionLevel(int level);
+
+    /**
+     * @brief Returns the total size of the stored frames in bytes.
+     */
+    qint64 compressedBytes() const;
+
+    /**
+     * @brief Returns the total size the stored frames would take up
+     * uncompressed, in bytes.
+     */
+    qint64 uncompressedBytes() const;
+
+    /**
+     * @brief Removes all frames and clears the cache.
+     */
+    void clear();
+
+private:
+    struct Frame
+    {
+        QByteArray data;
+        qint64 rawBytes = 0;
+        bool keyFrame = true;
+    };
+
+    int encode(const cv::Mat& payloadMat, QImage::Format format, bool keyFrame, Frame& frame) const;
+    QCVimgConstRef decode(qint64 serial, const QCVimgConstRef& previous);
+    QCVimgConstRef cachedFrame(qint64 serial);
+    void insertCached(qint64 serial, const QCVimgConstRef& decodedFrame);
+    void dropOldest();
+
+    std::unique_ptr<QCVimgPool> mOwnPool;
+    QCVimgPool* mPool;
+    std::deque<Frame> mFrames;
+    std::vector<std::pair<qint64, QCVimgConstRef>> mCache;
+    cv::Mat mReference;
+    cv::Mat mScratch;
+    QImage::Format mReferenceFormat = QImage::Format_Invalid;
+    qint64 mFirstSerial = 0;
+    qint64 mCompressedBytes = 0;
+    qint64 mUncompressedBytes = 0;
+    int mCapacity;
+    int mKeyFrameInterval;
+    int mCachedFrames;
+    int mCompressionLevel = 1;
+    int mFramesSinceKeyFrame = 0;
+};
+
+#endif // QCVIMGSTORE_H
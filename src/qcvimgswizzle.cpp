@@ -0,0 +1,231 @@
+﻿#include "qcvimgswizzle.h"
+#include "qcvimgexecution.h"
+
+#include <opencv2/core/utility.hpp>
+
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define QCVIMG_SWIZZLE_X86
+#  include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  define QCVIMG_SWIZZLE_NEON
+#  include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define QCVIMG_TARGET(isa) __attribute__((target(isa)))
+#else
+#  define QCVIMG_TARGET(isa)
+#endif
+
+
+namespace {
+
+using SwapKernel = void (*)(const uchar* source, uchar* dest, int pixels);
+
+struct SwapKernels
+{
+    SwapKernel rgb3;
+    SwapKernel rgb4;
+    const char* instructionSet;
+};
+
+// Below this many pixels splitting the work across threads costs more than it gains
+const int scParallelPixelThreshold = 1 << 18;
+
+void swapRedBlue3Scalar(const uchar* source, uchar* dest, int pixels)
+{
+    for (int i = 0; i < pixels; ++i, source += 3, dest += 3) {
+        const uchar red = source[0];
+        dest[1] = source[1];
+        dest[0] = source[2];
+        dest[2] = red;
+    }
+}
+
+void swapRedBlue4Scalar(const uchar* source, uchar* dest, int pixels)
+{
+    for (int i = 0; i < pixels; ++i, source += 4, dest += 4) {
+        const uchar red = source[0];
+        dest[1] = source[1];
+        dest[3] = source[3];
+        dest[0] = source[2];
+        dest[2] = red;
+    }
+}
+
+#if defined(QCVIMG_SWIZZLE_X86)
+
+QCVIMG_TARGET("ssse3")
+void swapRedBlue3Ssse3(const uchar* source, uchar* dest, int pixels)
+{
+    // 5 pixels (15 bytes) are swapped per iteration, the 16th byte is stored unchanged
+    const __m128i mask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+    int i = 0;
+
+    for (; i + 6 <= pixels; i += 5, source += 15, dest += 15) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_shuffle_epi8(chunk, mask));
+    }
+
+    swapRedBlue3Scalar(source, dest, pixels - i);
+}
+
+QCVIMG_TARGET("ssse3")
+void swapRedBlue4Ssse3(const uchar* source, uchar* dest, int pixels)
+{
+    const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    int i = 0;
+
+    for (; i + 4 <= pixels; i += 4, source += 16, dest += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_shuffle_epi8(chunk, mask));
+    }
+
+    swapRedBlue4Scalar(source, dest, pixels - i);
+}
+
+QCVIMG_TARGET("avx2")
+void swapRedBlue3Avx2(const uchar* source, uchar* dest, int pixels)
+{
+    // Each lane swaps 5 pixels (15 bytes), so 10 pixels are swapped per iteration. The
+    // unchanged 16th byte of the low lane is overwritten by the store of the high lane.
+    const __m256i mask = _mm256_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15,
+                                          2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+    int i = 0;
+
+    for (; i + 11 <= pixels; i += 10, source += 30, dest += 30) {
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 15));
+        const __m256i chunk = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1), mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm256_castsi256_si128(chunk));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 15), _mm256_extracti128_si256(chunk, 1));
+    }
+
+    swapRedBlue3Ssse3(source, dest, pixels - i);
+}
+
+QCVIMG_TARGET("avx2")
+void swapRedBlue4Avx2(const uchar* source, uchar* dest, int pixels)
+{
+    const __m256i mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                          2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    int i = 0;
+
+    for (; i + 8 <= pixels; i += 8, source += 32, dest += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest), _mm256_shuffle_epi8(chunk, mask));
+    }
+
+    swapRedBlue4Ssse3(source, dest, pixels - i);
+}
+
+#elif defined(QCVIMG_SWIZZLE_NEON)
+
+void swapRedBlue3Neon(const uchar* source, uchar* dest, int pixels)
+{
+    int i = 0;
+
+    for (; i + 16 <= pixels; i += 16, source += 48, dest += 48) {
+        uint8x16x3_t chunk = vld3q_u8(source);
+        std::swap(chunk.val[0], chunk.val[2]);
+        vst3q_u8(dest, chunk);
+    }
+
+    swapRedBlue3Scalar(source, dest, pixels - i);
+}
+
+void swapRedBlue4Neon(const uchar* source, uchar* dest, int pixels)
+{
+    int i = 0;
+
+    for (; i + 16 <= pixels; i += 16, source += 64, dest += 64) {
+        uint8x16x4_t chunk = vld4q_u8(source);
+        std::swap(chunk.val[0], chunk.val[2]);
+        vst4q_u8(dest, chunk);
+    }
+
+    swapRedBlue4Scalar(source, dest, pixels - i);
+}
+
+#endif
+
+SwapKernels selectKernels()
+{
+#if defined(QCVIMG_SWIZZLE_X86)
+    if (cv::checkHardwareSupport(CV_CPU_AVX2)) {
+        return {swapRedBlue3Avx2, swapRedBlue4Avx2, "AVX2"};
+    } else if (cv::checkHardwareSupport(CV_CPU_SSSE3)) {
+        return {swapRedBlue3Ssse3, swapRedBlue4Ssse3, "SSSE3"};
+    }
+#elif defined(QCVIMG_SWIZZLE_NEON)
+    return {swapRedBlue3Neon, swapRedBlue4Neon, "NEON"};
+#endif
+
+    return {swapRedBlue3Scalar, swapRedBlue4Scalar, "scalar"};
+}
+
+const SwapKernels& kernels()
+{
+    static const SwapKernels selectedKernels = selectKernels();
+
+    return selectedKernels;
+}
+
+}
+
+
+void QCVimgSwizzle::swapRedBlue(const uchar* source, uchar* dest, int pixels, int channels)
+{
+    if (channels == 3) {
+        kernels().rgb3(source, dest, pixels);
+    } else if (channels == 4) {
+        kernels().rgb4(source, dest, pixels);
+    }
+}
+
+int QCVimgSwizzle::swapRedBlue(const cv::Mat& source, cv::Mat& dest)
+{
+    if (source.type() != CV_8UC3 && source.type() != CV_8UC4) {
+        return -1;
+    }
+
+    if (source.data != dest.data) {
+        dest.create(source.rows, source.cols, source.type());
+    }
+
+    const int channels = source.channels();
+
+    if (source.isContinuous() && dest.isContinuous()) {
+        const int pixels = source.rows * source.cols;
+
+        if (pixels < scParallelPixelThreshold) {
+            swapRedBlue(source.data, dest.data, pixels, channels);
+        } else {
+            QCVimgExecution::current().parallelFor(cv::Range(0, source.rows), [&](const cv::Range& rows) {
+                swapRedBlue(source.ptr(rows.start), dest.ptr(rows.start),
+                            (rows.end - rows.start) * source.cols, channels);
+            });
+        }
+    } else {
+        auto swapRows = [&](const cv::Range& rows) {
+            for (int row = rows.start; row < rows.end; ++row) {
+                swapRedBlue(source.ptr(row), dest.ptr(row), source.cols, channels);
+            }
+        };
+
+        if (source.rows * source.cols < scParallelPixelThreshold) {
+            swapRows(cv::Range(0, source.rows));
+        } else {
+            QCVimgExecution::current().parallelFor(cv::Range(0, source.rows), swapRows);
+        }
+    }
+
+    return 0;
+}
+
+const char* QCVimgSwizzle::activeInstructionSet()
+{
+    return kernels().instructionSet;
+}
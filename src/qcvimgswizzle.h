@@ -0,0 +1,44 @@
+﻿#ifndef QCVIMGSWIZZLE_H
+#define QCVIMGSWIZZLE_H
+
+#include <QtGlobal>
+#include <opencv4/opencv2/core/mat.hpp>
+
+/**
+ * @brief Channel swizzle kernels used internally by QCVimg.
+ *
+ * The kernels swap the first and third channel of 8 bit, three or four channel
+ * pixels (RGB888 <-> BGR888, BGRA <-> RGBA, RGBX <-> BGRX), leaving the second
+ * and fourth channel (green and alpha/padding) in place. All of them accept
+ * either disjoint or identical source and destination buffers, the latter
+ * meaning in-place operation.
+ *
+ * The best available implementation (SSSE3, AVX2 or NEON, with a scalar
+ * fallback) is selected at runtime on first use, based on the CPU features
+ * reported by OpenCV.
+ */
+namespace QCVimgSwizzle
+{
+    /**
+     * @brief Swaps red and blue channels of @p pixels pixels.
+     * @param channels Number of channels per pixel, must be 3 or 4.
+     */
+    void swapRedBlue(const uchar* source, uchar* dest, int pixels, int channels);
+
+    /**
+     * @brief Swaps red and blue channels of a CV_8UC3 or CV_8UC4 image.
+     *
+     * If @p dest doesn't share data with @p source, it is (re)allocated
+     * through cv::Mat::create, which means that a @p dest with matching size
+     * and type is written in place.
+     * @return 0 on success, -1 on an unsupported image type.
+     */
+    int swapRedBlue(const cv::Mat& source, cv::Mat& dest);
+
+    /**
+     * @brief Returns the name of the instruction set the kernels run on.
+     */
+    const char* activeInstructionSet();
+}
+
+#endif // QCVIMGSWIZZLE_H
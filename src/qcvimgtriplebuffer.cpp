@@ -0,0 +1,37 @@
+﻿#include "qcvimgtriplebuffer.h"
+
+
+QCVimgCore& QCVimgTripleBuffer::back()
+{
+    return mImages[mBackIndex];
+}
+
+void QCVimgTripleBuffer::publish()
+{
+    // Release makes the writes into the back image visible to the consumer fetching it
+    const quint8 previous = mPublished.exchange(mBackIndex | scFreshFlag, std::memory_order_acq_rel);
+    mBackIndex = previous & scIndexMask;
+}
+
+void QCVimgTripleBuffer::publish(QCVimgCore&& frame)
+{
+    back() = std::move(frame);
+    publish();
+}
+
+bool QCVimgTripleBuffer::update()
+{
+    if ((mPublished.load(std::memory_order_relaxed) & scFreshFlag) == 0) {
+        return false;
+    }
+
+    const quint8 previous = mPublished.exchange(mFrontIndex, std::memory_order_acq_rel);
+    mFrontIndex = previous & scIndexMask;
+
+    return true;
+}
+
+QCVimgCore& QCVimgTripleBuffer::front()
+{
+    return mImages[mFrontIndex];
+}
@@ -0,0 +1,92 @@
+﻿#ifndef QCVIMGTRIPLEBUFFER_H
+#define QCVIMGTRIPLEBUFFER_H
+
+#include "qcvimglib_decl.h"
+#include "qcvimgcore.h"
+
+#include <array>
+#include <atomic>
+
+/**
+ * @brief A lock-free triple buffer handing the latest frame from a producer
+ * thread to a consumer thread.
+ *
+ * Unlike QCVimgQueue, frames aren't queued: the consumer always gets the
+ * most recently published one, and frames published in between are
+ * skipped. This suits e.g. a display thread, which should never fall behind
+ * a capture or processing thread.
+ *
+ * The buffer holds three images: the producer owns the back image, the
+ * consumer the front image, and the third one is the latest published frame.
+ * Publishing and fetching only exchange the index of the image with the
+ * published one (a single atomic exchange), no image data is moved or
+ * copied. The producer can write the next frame straight into #back, which
+ * then reuses the buffer of an image the consumer is already done with, so
+ * a steady stream of frames doesn't allocate.
+ *
+ * Exactly one thread may use the producer functions (#back, #publish), and
+ * exactly one thread the consumer functions (#update, #front).
+ */
+class QCVIMGLIB_EXPORT QCVimgTripleBuffer
+{
+public:
+    /**
+     * @brief Creates a triple buffer holding three empty images.
+     */
+    QCVimgTripleBuffer() = default;
+
+    QCVimgTripleBuffer(const QCVimgTripleBuffer&) = delete;
+    QCVimgTripleBuffer& operator=(const QCVimgTripleBuffer&) = delete;
+
+    /**
+     * @brief Returns the image the producer writes the next frame into.
+     *
+     * It contains an older frame (or is empty), whose buffer can be reused.
+     * Producer thread only.
+     */
+    QCVimgCore& back();
+
+    /**
+     * @brief Publishes the back image as the latest frame, and makes the
+     * image of the previously published frame the new back image.
+     *
+     * Producer thread only.
+     */
+    void publish();
+
+    /**
+     * @brief Moves @p frame into the back image, then publishes it.
+     *
+     * The previous back image data is released, and @p frame is left empty.
+     * Producer thread only.
+     */
+    void publish(QCVimgCore&& frame);
+
+    /**
+     * @brief Fetches the latest published frame, if there is a new one.
+     *
+     * Consumer thread only.
+     * @return True if a new frame was fetched into #front, false if nothing
+     * was published since the last call, in which case #front is unchanged.
+     */
+    bool update();
+
+    /**
+     * @brief Returns the image holding the frame fetched last by #update.
+     *
+     * Consumer thread only.
+     */
+    QCVimgCore& front();
+
+private:
+    static constexpr quint8 scIndexMask = 0x3;
+    static constexpr quint8 scFreshFlag = 0x4;
+
+    std::array<QCVimgCore, 3> mImages;
+    quint8 mBackIndex = 0;
+    // Index of the published image, and a flag telling if the consumer has fetched it yet
+    alignas(64) std::atomic<quint8> mPublished{1};
+    alignas(64) quint8 mFrontIndex = 2;
+};
+
+#endif // QCVIMGTRIPLEBUFFER_H
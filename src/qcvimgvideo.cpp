@@ -0,0 +1,303 @@
+﻿#include "qcvimgvideo.h"
+#include "qcvimgpool.h"
+
+#include <QVideoFrame>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+#  include <QVideoFrameFormat>
+#endif
+#include <opencv2/imgproc.hpp>
+
+#if defined(Q_OS_LINUX)
+#  include <linux/dma-buf.h>
+#  include <sys/ioctl.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+
+#  include <cerrno>
+#endif
+
+#include <utility>
+
+
+namespace {
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+using VideoFormat = QVideoFrameFormat;
+const QVideoFrame::MapMode scReadWrite = QVideoFrame::ReadWrite;
+const QVideoFrame::MapMode scReadOnly = QVideoFrame::ReadOnly;
+#else
+using VideoFormat = QVideoFrame;
+const QAbstractVideoBuffer::MapMode scReadWrite = QAbstractVideoBuffer::ReadWrite;
+const QAbstractVideoBuffer::MapMode scReadOnly = QAbstractVideoBuffer::ReadOnly;
+#endif
+
+int conversionCode(QCVimgVideo::YuvLayout layout, bool bgra)
+{
+    switch (layout) {
+    case QCVimgVideo::YuvLayout::NV12:
+        return bgra ? cv::COLOR_YUV2BGRA_NV12 : cv::COLOR_YUV2RGB_NV12;
+    case QCVimgVideo::YuvLayout::NV21:
+        return bgra ? cv::COLOR_YUV2BGRA_NV21 : cv::COLOR_YUV2RGB_NV21;
+    case QCVimgVideo::YuvLayout::YUYV:
+        return bgra ? cv::COLOR_YUV2BGRA_YUYV : cv::COLOR_YUV2RGB_YUYV;
+    case QCVimgVideo::YuvLayout::UYVY:
+        return bgra ? cv::COLOR_YUV2BGRA_UYVY : cv::COLOR_YUV2RGB_UYVY;
+    }
+
+    return -1;
+}
+
+bool isPlanar(QCVimgVideo::YuvLayout layout)
+{
+    return layout == QCVimgVideo::YuvLayout::NV12 || layout == QCVimgVideo::YuvLayout::NV21;
+}
+
+bool findYuvLayout(VideoFormat::PixelFormat pixelFormat, QCVimgVideo::YuvLayout& layout)
+{
+    switch (pixelFormat) {
+    case VideoFormat::Format_NV12:
+        layout = QCVimgVideo::YuvLayout::NV12;
+        return true;
+    case VideoFormat::Format_NV21:
+        layout = QCVimgVideo::YuvLayout::NV21;
+        return true;
+    case VideoFormat::Format_YUYV:
+        layout = QCVimgVideo::YuvLayout::YUYV;
+        return true;
+    case VideoFormat::Format_UYVY:
+        layout = QCVimgVideo::YuvLayout::UYVY;
+        return true;
+    default:
+        return false;
+    }
+}
+
+void releaseMappedFrame(void* mappedFrame)
+{
+    auto frame = static_cast<QVideoFrame*>(mappedFrame);
+    frame->unmap();
+    delete frame;
+}
+
+#if defined(Q_OS_LINUX)
+
+struct MappedDmaBuf
+{
+    uchar* data = nullptr;
+    size_t size = 0;
+};
+
+bool syncDmaBuf(int fd, quint64 flags)
+{
+    dma_buf_sync sync = {flags};
+    int result;
+
+    do {
+        result = ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync);
+    } while (result == -1 && errno == EINTR);
+
+    return result == 0;
+}
+
+bool mapDmaBuf(int fd, MappedDmaBuf& mapping)
+{
+    const off_t size = lseek(fd, 0, SEEK_END);
+
+    if (size <= 0) {
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    mapping.data = static_cast<uchar*>(data);
+    mapping.size = static_cast<size_t>(size);
+    return true;
+}
+
+// The mapping outlives the descriptor, so the end of the access is signalled
+// on a duplicate kept along with it
+struct DmaBufImage
+{
+    MappedDmaBuf mapping;
+    int fd = -1;
+};
+
+void releaseDmaBufImage(void* dmaBufImage)
+{
+    auto image = static_cast<DmaBufImage*>(dmaBufImage);
+    syncDmaBuf(image->fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_RW);
+    munmap(image->mapping.data, image->mapping.size);
+    close(image->fd);
+    delete image;
+}
+
+#endif
+
+} // namespace
+
+
+QCVimgCore QCVimgVideo::fromVideoFrame(const QVideoFrame& frame, QCVimgPool* pool, QImage::Format yuvTargetFormat)
+{
+    const QImage::Format wrappedFormat = VideoFormat::imageFormatFromPixelFormat(frame.pixelFormat());
+    YuvLayout layout;
+
+    if (QCVimgCore::isValidQImgFormat(wrappedFormat)) {
+        // The copy shares the frame buffer, and keeps it mapped for the image
+        auto mappedFrame = new QVideoFrame(frame);
+
+        if (!mappedFrame->map(scReadWrite)) {
+            delete mappedFrame;
+            return QCVimgCore();
+        }
+
+        QImage wrappedQImg(mappedFrame->bits(0), mappedFrame->width(), mappedFrame->height(),
+                           mappedFrame->bytesPerLine(0), wrappedFormat, releaseMappedFrame, mappedFrame);
+
+        // QImage doesn't call the cleanup function if it couldn't be created
+        if (wrappedQImg.isNull()) {
+            releaseMappedFrame(mappedFrame);
+            return QCVimgCore();
+        }
+
+        return QCVimgCore(std::move(wrappedQImg));
+    } else if (findYuvLayout(frame.pixelFormat(), layout)) {
+        QVideoFrame mappedFrame(frame);
+
+        if (!mappedFrame.map(scReadOnly)) {
+            return QCVimgCore();
+        }
+
+        const uchar* planes[2] = {mappedFrame.bits(0), isPlanar(layout) ? mappedFrame.bits(1) : nullptr};
+        const int bytesPerLine[2] = {mappedFrame.bytesPerLine(0), isPlanar(layout) ? mappedFrame.bytesPerLine(1) : 0};
+        QCVimgCore convertedImg;
+
+        if (pool != nullptr) {
+            convertedImg = static_cast<QCVimgCore&&>(pool->acquire(frame.width(), frame.height(), yuvTargetFormat));
+        }
+
+        const int result = convertYuv(layout, planes, bytesPerLine, frame.width(), frame.height(),
+                                      convertedImg, yuvTargetFormat);
+        mappedFrame.unmap();
+
+        return result == 0 ? std::move(convertedImg) : QCVimgCore();
+    } else {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        return QCVimgCore(frame.toImage());
+#elif QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+        return QCVimgCore(frame.image());
+#else
+        return QCVimgCore();
+#endif
+    }
+}
+
+int QCVimgVideo::convertYuv(YuvLayout layout, const uchar* const planes[2], const int bytesPerLine[2],
+                            int width, int height, QCVimgCore& dest, QImage::Format format)
+{
+    const bool bgra = format == QImage::Format_RGB32 || format == QImage::Format_ARGB32;
+
+    if ((format != QImage::Format_RGB888 && !bgra) || width <= 0 || height <= 0 || width % 2 != 0 ||
+        (isPlanar(layout) && height % 2 != 0) || planes[0] == nullptr || (isPlanar(layout) && planes[1] == nullptr))
+    {
+        return -1;
+    }
+
+    if (dest.width() != width || dest.height() != height || dest.qFormat() != format ||
+        dest.shared() || !dest.isMatBound())
+    {
+        dest = QCVimgCore(width, height, format);
+    }
+
+    QCVIMG_STATS_TIMER(Conversion);
+    cv::Mat& destMat = dest.cvMat();
+    const int code = conversionCode(layout, bgra);
+
+    // The Mats only describe the mapped planes, the result is written straight into dest
+    if (isPlanar(layout)) {
+        const cv::Mat yPlane(height, width, CV_8UC1, const_cast<uchar*>(planes[0]),
+                             static_cast<size_t>(bytesPerLine[0]));
+        const cv::Mat uvPlane(height / 2, width / 2, CV_8UC2, const_cast<uchar*>(planes[1]),
+                              static_cast<size_t>(bytesPerLine[1]));
+        cv::cvtColorTwoPlane(yPlane, uvPlane, destMat, code);
+    } else {
+        const cv::Mat packed(height, width, CV_8UC2, const_cast<uchar*>(planes[0]),
+                             static_cast<size_t>(bytesPerLine[0]));
+        cv::cvtColor(packed, destMat, code);
+    }
+
+    dest.markDirty();
+    QCVIMG_STATS_RECORD(Conversion, dest.bytes());
+    return 0;
+}
+
+#if defined(Q_OS_LINUX)
+
+QCVimgCore QCVimgVideo::fromDmaBuf(int fd, int width, int height, int bytesPerLine, QImage::Format format, qint64 offset)
+{
+    if (!QCVimgCore::isValidQImgFormat(format) || width <= 0 || height <= 0 || offset < 0) {
+        return QCVimgCore();
+    }
+
+    auto dmaBufImage = new DmaBufImage;
+    dmaBufImage->fd = dup(fd);
+
+    if (dmaBufImage->fd == -1 || !mapDmaBuf(dmaBufImage->fd, dmaBufImage->mapping)) {
+        if (dmaBufImage->fd != -1) {
+            close(dmaBufImage->fd);
+        }
+
+        delete dmaBufImage;
+        return QCVimgCore();
+    }
+
+    if (offset + static_cast<qint64>(bytesPerLine) * height > static_cast<qint64>(dmaBufImage->mapping.size)) {
+        munmap(dmaBufImage->mapping.data, dmaBufImage->mapping.size);
+        close(dmaBufImage->fd);
+        delete dmaBufImage;
+        return QCVimgCore();
+    }
+
+    syncDmaBuf(dmaBufImage->fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_RW);
+    QImage wrappedQImg(dmaBufImage->mapping.data + offset, width, height, bytesPerLine, format,
+                       releaseDmaBufImage, dmaBufImage);
+
+    if (wrappedQImg.isNull()) {
+        releaseDmaBufImage(dmaBufImage);
+        return QCVimgCore();
+    }
+
+    return QCVimgCore(std::move(wrappedQImg));
+}
+
+int QCVimgVideo::convertDmaBuf(int fd, YuvLayout layout, int width, int height, int bytesPerLine,
+                               QCVimgCore& dest, QImage::Format format, qint64 offset, qint64 uvOffset)
+{
+    MappedDmaBuf mapping;
+
+    if (width <= 0 || height <= 0 || offset < 0 || !mapDmaBuf(fd, mapping)) {
+        return -1;
+    }
+
+    const qint64 planeOffset = uvOffset < 0 ? offset + static_cast<qint64>(bytesPerLine) * height : uvOffset;
+    const qint64 lastByte = isPlanar(layout) ? planeOffset + static_cast<qint64>(bytesPerLine) * (height / 2)
+                                             : offset + static_cast<qint64>(bytesPerLine) * height;
+    int result = -1;
+
+    if (lastByte <= static_cast<qint64>(mapping.size)) {
+        const uchar* planes[2] = {mapping.data + offset, isPlanar(layout) ? mapping.data + planeOffset : nullptr};
+        const int planeBytesPerLine[2] = {bytesPerLine, bytesPerLine};
+
+        syncDmaBuf(fd, DMA_BUF_SYNC_START | DMA_BUF_SYNC_READ);
+        result = convertYuv(layout, planes, planeBytesPerLine, width, height, dest, format);
+        syncDmaBuf(fd, DMA_BUF_SYNC_END | DMA_BUF_SYNC_READ);
+    }
+
+    munmap(mapping.data, mapping.size);
+    return result;
+}
+
+#endif
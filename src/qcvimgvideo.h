@@ -0,0 +1,114 @@
+﻿#ifndef QCVIMGVIDEO_H
+#define QCVIMGVIDEO_H
+
+#include "qcvimglib_decl.h"
+#include "qcvimgcore.h"
+
+#include <QImage>
+
+class QCVimgPool;
+class QVideoFrame;
+
+/**
+ * @brief Zero-copy import of video frames from Qt Multimedia and Linux
+ * DMABUF buffers.
+ *
+ * Frames with a memory layout compatible with QCVimgCore (e.g. RGB32, ARGB32
+ * or RGB888) are wrapped instead of copied: the frame (or buffer) stays
+ * mapped as long as the returned image (or any QImage sharing its data)
+ * exists, and both members of the image point directly into the mapping.
+ * The mapping is writable, so modifying the image modifies the frame, unless
+ * the image is detached from it first (e.g. by copying it).
+ *
+ * YUV frames (NV12, NV21, YUYV and UYVY) are converted straight from the
+ * mapped planes into the destination buffer by OpenCV's vectorized color
+ * conversion kernels, without any intermediate copy. Passing a QCVimgPool (or
+ * reusing the destination with #convertYuv) makes the conversion allocation
+ * free as well.
+ *
+ * Only available if the library is built with Qt Multimedia, the DMABUF
+ * functions only on Linux.
+ */
+namespace QCVimgVideo
+{
+    /**
+     * @brief Layouts of the YUV formats #convertYuv can convert.
+     *
+     * NV12 and NV21 consist of a full resolution Y plane, followed by a half
+     * resolution plane of interleaved U and V (V and U for NV21) samples. YUYV
+     * and UYVY are packed, with two pixels sharing a U and a V sample.
+     */
+    enum class YuvLayout : uint8_t {NV12, NV21, YUYV, UYVY};
+
+    /**
+     * @brief Creates an image from a video frame, wrapping its data if
+     * possible.
+     *
+     * Frames in a format compatible with QCVimgCore are mapped and wrapped
+     * without a copy, see QCVimgVideo. YUV frames are converted into
+     * @p yuvTargetFormat (see #convertYuv), into a buffer from @p pool if
+     * given. Other formats are converted by Qt (with Qt 5.15 or later).
+     * @param frame The frame to import. It is shared, not copied.
+     * @param pool Pool for the buffers of converted frames, or nullptr.
+     * @param yuvTargetFormat Format of converted YUV frames, see #convertYuv.
+     * @return The image, or an empty image if the frame can't be mapped or
+     * has an unsupported format.
+     */
+    QCVIMGLIB_EXPORT QCVimgCore fromVideoFrame(const QVideoFrame& frame, QCVimgPool* pool = nullptr,
+                                               QImage::Format yuvTargetFormat = QImage::Format_RGB888);
+
+    /**
+     * @brief Converts a YUV image given by its planes into @p dest.
+     *
+     * If @p dest already has the given size and @p format (and its data isn't
+     * shared), its buffer is reused, otherwise a new one is allocated. The
+     * BT.601 video range coefficients of cv::cvtColor are used.
+     * @param layout Layout of the source data.
+     * @param planes The Y and UV planes for NV12 and NV21, only the first one
+     * is used for the packed layouts.
+     * @param bytesPerLine Strides of @p planes.
+     * @param width Width of the image, must be even.
+     * @param height Height of the image, must be even for NV12 and NV21.
+     * @param dest Destination image.
+     * @param format Format of the result, QImage::Format_RGB888,
+     * QImage::Format_RGB32 or QImage::Format_ARGB32.
+     * @return 0 on success, -1 on an unsupported @p format or invalid size.
+     */
+    QCVIMGLIB_EXPORT int convertYuv(YuvLayout layout, const uchar* const planes[2], const int bytesPerLine[2],
+                                    int width, int height, QCVimgCore& dest,
+                                    QImage::Format format = QImage::Format_RGB888);
+
+#if defined(Q_OS_LINUX)
+    /**
+     * @brief Creates an image on top of a DMABUF buffer (e.g. exported by a
+     * V4L2 capture device with VIDIOC_EXPBUF) without copying it.
+     *
+     * The buffer is mapped, and a CPU access is started on it for the
+     * lifetime of the image (DMA_BUF_IOCTL_SYNC), which is ended and the
+     * buffer unmapped when the last QImage referencing it is destroyed. @p fd
+     * itself can be closed after the call.
+     * @param fd File descriptor of the DMABUF.
+     * @param offset Offset of the first scanline in the buffer, in bytes.
+     * @return The image, or an empty image on an incompatible format, or if
+     * the buffer can't be mapped or is too small.
+     */
+    QCVIMGLIB_EXPORT QCVimgCore fromDmaBuf(int fd, int width, int height, int bytesPerLine,
+                                           QImage::Format format, qint64 offset = 0);
+
+    /**
+     * @brief Converts a YUV image in a DMABUF buffer into @p dest, see
+     * #convertYuv.
+     *
+     * The buffer is only mapped for the duration of the conversion.
+     * @param uvOffset Offset of the UV plane for NV12 and NV21, if negative,
+     * the plane is expected right after the Y plane.
+     * @return 0 on success, -1 if the buffer can't be mapped or in the cases
+     * listed at #convertYuv.
+     */
+    QCVIMGLIB_EXPORT int convertDmaBuf(int fd, YuvLayout layout, int width, int height, int bytesPerLine,
+                                       QCVimgCore& dest, QImage::Format format = QImage::Format_RGB888,
+                                       qint64 offset = 0, qint64 uvOffset = -1);
+#endif
+}
+
+#endif // QCVIMGVIDEO_H
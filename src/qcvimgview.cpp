@@ -0,0 +1,49 @@
+﻿#include "qcvimgview.h"
+
+
+QCVimgView::QCVimgView(uchar* data, const QRect& rect, int bytesPerLine, QImage::Format qFormat, int matFormat)
+    : mQImg(data, rect.width(), rect.height(), bytesPerLine, qFormat),
+      mMImg(rect.height(), rect.width(), matFormat, data, static_cast<unsigned long>(bytesPerLine)),
+      mRect(rect)
+{
+}
+
+QImage& QCVimgView::qImg()
+{
+    return mQImg;
+}
+
+const QImage& QCVimgView::qImg() const
+{
+    return mQImg;
+}
+
+cv::Mat& QCVimgView::cvMat()
+{
+    return mMImg;
+}
+
+const cv::Mat& QCVimgView::cvMat() const
+{
+    return mMImg;
+}
+
+bool QCVimgView::empty() const
+{
+    return mQImg.isNull();
+}
+
+QRect QCVimgView::rect() const
+{
+    return mRect;
+}
+
+int QCVimgView::width() const
+{
+    return mQImg.width();
+}
+
+int QCVimgView::height() const
+{
+    return mQImg.height();
+}
@@ -0,0 +1,92 @@
+﻿#ifndef QCVIMGVIEW_H
+#define QCVIMGVIEW_H
+
+#include "qcvimglib_decl.h"
+
+#include <QImage>
+#include <QRect>
+#include <opencv4/opencv2/core/mat.hpp>
+
+/**
+ * @brief A lightweight, non-owning view of a rectangular region of a QCVimg.
+ *
+ * Just like QCVimg, the view provides a QImage and a cv::Mat interface to the
+ * same data, but instead of owning it, both of them point directly into the
+ * buffer of the parent image (a sub-rectangle of it, using the parent's
+ * bytesPerLine as stride). Creating a view therefore never allocates or copies
+ * any image data, and any modification done through the view is immediately
+ * visible in the parent image and vice versa.
+ *
+ * Views are only valid as long as the parent image is alive and its data is
+ * not reallocated (e.g. by copying a different image into it, or by changing
+ * its format). Using a view after that results in undefined behavior.
+ *
+ * _IMPORTANT:_ Copying the view is cheap (shallow), but the usual QImage COW
+ * rules apply to the QImage member: modifying the QImage of a view that is
+ * shared with another QImage detaches it from the parent data. The cv::Mat
+ * member always points to the parent data.
+ * @see QCVimgCore::view
+ */
+class QCVIMGLIB_EXPORT QCVimgView
+{
+public:
+    /**
+     * @brief Creates an empty view.
+     */
+    QCVimgView() = default;
+
+    /**
+     * @brief Returns a reference to the QImage interface of the view.
+     */
+    QImage& qImg();
+
+    /**
+     * @brief Returns a const reference to the QImage interface of the view.
+     */
+    const QImage& qImg() const;
+
+    /**
+     * @brief Returns a reference to the cv::Mat interface of the view.
+     *
+     * The Mat is an ROI header over the parent image data. See OpenCV
+     * documentation on what functions might reallocate it.
+     */
+    cv::Mat& cvMat();
+
+    /**
+     * @brief Returns a const reference to the cv::Mat interface of the view.
+     */
+    const cv::Mat& cvMat() const;
+
+    /**
+     * @brief Tells if the view is empty.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Returns the region of the parent image covered by the view, in
+     * parent image coordinates.
+     */
+    QRect rect() const;
+
+    /**
+     * @brief Returns the width of the view.
+     */
+    int width() const;
+
+    /**
+     * @brief Returns the height of the view.
+     */
+    int height() const;
+
+private:
+    friend class QCVimgCore;
+
+    QCVimgView(uchar* data, const QRect& rect, int bytesPerLine, QImage::Format qFormat, int matFormat);
+
+    QImage mQImg;
+    cv::Mat mMImg;
+    QRect mRect;
+};
+
+#endif // QCVIMGVIEW_H
@@ -2,11 +2,31 @@
 #include <gmock/gmock.h>
 
 #include "qcvimg.h"
+#include "qcvimgbatch.h"
+#include "qcvimgpipeline.h"
+#include "qcvimgpool.h"
+#include "qcvimgqueue.h"
+#include "qcvimgreader.h"
+#include "qcvimgstore.h"
+#include "qcvimgtriplebuffer.h"
+#ifdef QT_MULTIMEDIA_LIB
+#  include "qcvimgvideo.h"
+#endif
 
 #include <QBuffer>
 #include <QDebug>
 #include <QImage>
+#include <QSharedMemory>
+#include <QTemporaryFile>
+#include <QThreadPool>
+#include <opencv4/opencv2/core.hpp>
 #include <opencv4/opencv2/core/mat.hpp>
+#include <opencv4/opencv2/imgproc.hpp>
+
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
 
 using namespace testing;
 
@@ -133,6 +153,10 @@ QImageFormatCase validQImageFormatCases[] = {
     QImageFormatCase(QImage::Format_RGB888, CV_8UC3),
     QImageFormatCase(QImage::Format_Alpha8, CV_8UC1),
     QImageFormatCase(QImage::Format_Grayscale8, CV_8UC1),
+    QImageFormatCase(QImage::Format_RGBX8888, CV_8UC4),
+    QImageFormatCase(QImage::Format_RGBA8888, CV_8UC4),
+    QImageFormatCase(QImage::Format_RGBX64, CV_16UC4),
+    QImageFormatCase(QImage::Format_RGBA64, CV_16UC4),
 //    FormatConvertCase(QImage::Format_Grayscale16, CV_16UC1) needs >= Qt 5.13
 };
 
@@ -157,7 +181,7 @@ QImageFormatCase invalidQImageFormatCases[] = {
     QImageFormatCase(QImage::Format_RGB444, -1),
     QImageFormatCase(QImage::Format_RGB666, -1),
     QImageFormatCase(QImage::Format_RGB16, -1),
-    QImageFormatCase(QImage::Format_RGBA64, -1)
+    QImageFormatCase(QImage::Format_RGB30, -1)
 };
 
 TEST_P(QCVimgConstructFromQImageWithFormat2, InvalidQImageFormatReturnsEmptyImage)
@@ -171,6 +195,71 @@ TEST_P(QCVimgConstructFromQImageWithFormat2, InvalidQImageFormatReturnsEmptyImag
 }
 INSTANTIATE_TEST_SUITE_P(QCVimg_BulkTest, QCVimgConstructFromQImageWithFormat2, ValuesIn(invalidQImageFormatCases));
 
+TEST(QCVimgFormatLookup, FormatsOutsideOfLookupTablesAreInvalid)
+{
+    EXPECT_THAT(QCVimg::convertQImgFormatTag(QImage::NImageFormats), Eq(-1));
+    EXPECT_THAT(QCVimg::convertMatFormatTag(-1), Eq(QImage::Format_Invalid));
+    ASSERT_THAT(QCVimg::convertMatFormatTag(CV_8UC(5)), Eq(QImage::Format_Invalid));
+}
+
+TEST(QCVimgFormatLookup, FormatTraitsAreAvailableAtCompileTime)
+{
+    static_assert(QCVimgFormatTraits<QImage::Format_RGB888>::matFormat == CV_8UC3, "");
+    static_assert(QCVimgFormatTraits<QImage::Format_ARGB32>::channels == 4, "");
+    static_assert(!QCVimgFormatTraits<QImage::Format_Mono>::isValid, "");
+    static_assert(QCVimg::isValidMatFormat(CV_16UC1), "");
+
+    SUCCEED();
+}
+
+TEST(QCVimgFormatLookup, FourChannelHighBitDepthMatMapsToRgba64)
+{
+    EXPECT_THAT(QCVimg::convertMatFormatTag(CV_16UC4), Eq(QImage::Format_RGBA64));
+    ASSERT_FALSE(QCVimg::isValidMatFormat(CV_32FC1));
+}
+
+TEST(QCVimgFormatLookup, MatIsBoundWithRequestedEquivalentFormat)
+{
+    cv::Mat rgbaMat(3, 5, CV_8UC4, cv::Scalar(10, 20, 30, 255));
+
+    QCVimg img(rgbaMat, QImage::Format_RGBA8888);
+
+    EXPECT_THAT(img.qFormat(), Eq(QImage::Format_RGBA8888));
+    ASSERT_THAT(img.pixelColor(1,1), Eq(QColor(10, 20, 30)));
+}
+
+TEST(QCVimgFormatLookup, MatIsRejectedWithNonEquivalentFormat)
+{
+    cv::Mat rgbMat(3, 5, CV_8UC3);
+
+    QCVimg img(rgbMat, QImage::Format_RGBA8888);
+
+    ASSERT_TRUE(img.empty());
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+TEST(QCVimgFormatLookup, NativeBgrMatIsAdoptedWithoutSwappingChannels)
+{
+    cv::Mat bgrMat(4, 8, CV_8UC3, cv::Scalar(100, 50, 30));
+    auto bgrData = bgrMat.data;
+
+    QCVimg img(std::move(bgrMat), QImage::Format_BGR888);
+
+    EXPECT_THAT(img.qImg().constBits(), Eq(bgrData));
+    EXPECT_THAT(img.cvMat().at<cv::Vec3b>(1,1)[0], Eq(100));
+    ASSERT_THAT(img.pixelColor(1,1), Eq(QColor(30, 50, 100)));
+}
+#endif
+
+TEST(QCVimgFormatLookup, CompileTimeFormattedImageIsBound)
+{
+    QCVimgT<QImage::Format_RGB888> img(7, 3);
+
+    EXPECT_THAT(img.qFormat(), Eq(QImage::Format_RGB888));
+    EXPECT_THAT(img.matFormat(), Eq(CV_8UC3));
+    ASSERT_TRUE(img.isMatBound());
+}
+
 TEST_F(QCVimgConstructFromQImage, MovingOriginalQImageIntoQCVimgLeavesOriginalEmtpy)
 {
     img = QCVimg(std::move(qOrigImg));
@@ -259,6 +348,120 @@ TEST_F(QCVimgConstructFromMat2, SourceImageWithBGRColorOrderConvertsToRGBDuringC
     ASSERT_THAT(imgPixel.rgb(), Eq(originalFillRgbColor.rgb()));
 }
 
+struct QCVimgAdoptMat : public Test
+{
+    void SetUp() override {
+        originalFillRgbColor = qRgb(30, 50, 100);
+        matOrigImg = cv::Mat(originalHeight, originalWidth, CV_8UC3, QCVimg::convertQColorToScalar(originalFillRgbColor, MatColorOrder::BGR));
+    }
+
+    QCVimg img;
+    cv::Mat matOrigImg;
+    QColor originalFillRgbColor;
+    int originalWidth = 12, originalHeight = 7;
+};
+
+TEST_F(QCVimgAdoptMat, QImageMemberPointsToAdoptedMatData)
+{
+    auto originalImgDataPtr = matOrigImg.data;
+
+    img = QCVimg(std::move(matOrigImg), MatColorOrder::BGR);
+
+    ASSERT_THAT(img.qImg().constBits(), Eq(originalImgDataPtr));
+    ASSERT_TRUE(img.isMatBound());
+}
+
+TEST_F(QCVimgAdoptMat, LazyAdoptionSwapsChannelsOnFirstAccess)
+{
+    auto originalImgDataPtr = matOrigImg.data;
+
+    img = QCVimg(std::move(matOrigImg), MatColorOrder::BGR, BindingMode::Lazy);
+
+    EXPECT_THAT(img.bindingMode(), Eq(BindingMode::Lazy));
+    EXPECT_THAT(img.pixelColor(3, 2), Eq(originalFillRgbColor));
+    ASSERT_THAT(img.qImg().constBits(), Eq(originalImgDataPtr));
+}
+
+TEST_F(QCVimgAdoptMat, ConvertingLazyImageUsesSwappedData)
+{
+    img = QCVimg(std::move(matOrigImg), MatColorOrder::BGR, BindingMode::Lazy);
+
+    QCVimgCore convertedImg = img.convertToFormat(QImage::Format_ARGB32);
+
+    EXPECT_THAT(convertedImg.qFormat(), Eq(QImage::Format_ARGB32));
+    ASSERT_THAT(convertedImg.pixelColor(3, 2), Eq(originalFillRgbColor));
+}
+
+TEST_F(QCVimgAdoptMat, ResizingLazyImageUsesSwappedData)
+{
+    img = QCVimg(std::move(matOrigImg), MatColorOrder::BGR, BindingMode::Lazy);
+
+    QCVimgCore resizedImg = img.resize(6, 4, ResizeInterpolation::Area);
+
+    EXPECT_THAT(resizedImg.width(), Eq(6));
+    ASSERT_THAT(resizedImg.pixelColor(2, 1), Eq(originalFillRgbColor));
+}
+
+TEST_F(QCVimgAdoptMat, AdoptedMatIsLeftEmpty)
+{
+    img = QCVimg(std::move(matOrigImg), MatColorOrder::BGR);
+
+    ASSERT_TRUE(matOrigImg.empty());
+}
+
+TEST_F(QCVimgAdoptMat, SourceImageWithBGRColorOrderConvertsToRGBInPlace)
+{
+    img = QCVimg(std::move(matOrigImg), MatColorOrder::BGR);
+
+    QColor imgPixel = img.pixelColor(1,1);
+
+    ASSERT_THAT(imgPixel.rgb(), Eq(originalFillRgbColor.rgb()));
+}
+
+TEST_F(QCVimgAdoptMat, AdoptedDataOutlivesDestroyedQCVimg)
+{
+    QImage sharedQImg;
+    {
+        QCVimg tempImg(std::move(matOrigImg), MatColorOrder::BGR);
+        sharedQImg = tempImg.qImg();
+    }
+
+    ASSERT_THAT(sharedQImg.pixelColor(1,1).rgb(), Eq(originalFillRgbColor.rgb()));
+}
+
+TEST_F(QCVimgAdoptMat, MatWithExternalDataIsCopiedInsteadOfAdopted)
+{
+    cv::Mat externalMat(originalHeight, originalWidth, CV_8UC3, matOrigImg.data, matOrigImg.step[0]);
+
+    img = QCVimg(std::move(externalMat));
+
+    ASSERT_THAT(img.qImg().constBits(), Ne(matOrigImg.data));
+    ASSERT_TRUE(img.isMatBound());
+}
+
+TEST_F(QCVimgAdoptMat, MatWithUnalignedScanlinesIsCopiedInsteadOfAdopted)
+{
+    cv::Mat unalignedMat(originalHeight, 13, CV_8UC3, cv::Scalar(30, 50, 100));
+    auto unalignedDataPtr = unalignedMat.data;
+
+    img = QCVimg(std::move(unalignedMat));
+
+    EXPECT_THAT(img.qImg().constBits(), Ne(unalignedDataPtr));
+    EXPECT_THAT(img.qImg().bytesPerLine() % 4, Eq(0));
+    ASSERT_THAT(img.pixelColor(12, 6), Eq(QColor(30, 50, 100)));
+}
+
+TEST_F(QCVimgAdoptMat, SharedBgrMatIsNotSwappedInPlace)
+{
+    cv::Mat sharedMat = matOrigImg;
+
+    img = QCVimg(cv::Mat(sharedMat), MatColorOrder::BGR);
+
+    EXPECT_THAT(img.qImg().constBits(), Ne(matOrigImg.data));
+    EXPECT_THAT(img.pixelColor(1, 1), Eq(originalFillRgbColor));
+    ASSERT_THAT(matOrigImg.at<cv::Vec3b>(1, 1)[0], Eq(originalFillRgbColor.blue()));
+}
+
 struct MatFormatCase
 {
     MatFormatCase(int argMatFormat, QImage::Format argExpectedQFormat)
@@ -551,6 +754,259 @@ TEST_F(QCVimgConstructFromQCVimg, OriginalImageMatMemberDoesNotPointToMovedToIma
     ASSERT_THAT(originalAfterMoveDataPtr, Ne(originalDataPtr));
 }
 
+TEST(QCVimgCoreValueType, MovesAreNoexcept)
+{
+    EXPECT_TRUE(std::is_nothrow_move_constructible<QCVimgCore>::value);
+    ASSERT_TRUE(std::is_nothrow_move_assignable<QCVimgCore>::value);
+}
+
+TEST(QCVimgCoreValueType, ImagesStayBoundAfterContainerReallocation)
+{
+    std::vector<QCVimgCore> images;
+
+    for (int i = 0; i < 100; ++i) {
+        images.emplace_back(4, 3, QImage::Format_Grayscale8);
+    }
+
+    for (const auto& image : images) {
+        ASSERT_TRUE(image.isMatBound());
+    }
+}
+
+TEST(QCVimgCoreValueType, MoveAssignmentReleasesPreviousData)
+{
+    QCVimgCore source(5, 3, QImage::Format_RGB888);
+    QCVimgCore dest(4, 2, QImage::Format_Grayscale8);
+    const QImage previousData = std::as_const(dest).qImg();
+
+    dest = std::move(source);
+
+    EXPECT_TRUE(source.empty());
+    ASSERT_TRUE(previousData.isDetached());
+}
+
+TEST(QCVimgCoreValueType, QCVimgTakesOverMovedInCoreData)
+{
+    QCVimgCore core(5, 3, QImage::Format_RGB888);
+    auto coreDataPtr = core.qImg().constBits();
+
+    QCVimg img(std::move(core));
+
+    EXPECT_TRUE(core.empty());
+    EXPECT_THAT(img.qImg().constBits(), Eq(coreDataPtr));
+    ASSERT_TRUE(img.isMatBound());
+}
+
+struct QCVimgDetach : public Test
+{
+    void SetUp() override {
+        QCVimgCore::resetCopyStats();
+    }
+
+    QCVimgCore img{6, 4, QImage::Format_RGB888};
+};
+
+TEST_F(QCVimgDetach, ImageSharingItsQImageIsReportedShared)
+{
+    EXPECT_FALSE(img.shared());
+
+    QImage sharingQImg = img.qImg();
+
+    ASSERT_TRUE(img.shared());
+}
+
+TEST_F(QCVimgDetach, DetachingSharedImageCopiesDataAndRebindsMat)
+{
+    QImage sharingQImg = img.qImg();
+
+    bool copied = img.detach();
+
+    EXPECT_TRUE(copied);
+    EXPECT_FALSE(img.shared());
+    EXPECT_THAT(img.qImg().constBits(), Ne(sharingQImg.constBits()));
+    EXPECT_TRUE(img.isMatBound());
+    ASSERT_THAT(QCVimgCore::copyStats().detaches, Eq(1u));
+}
+
+TEST_F(QCVimgDetach, DetachingUnsharedImageKeepsData)
+{
+    auto dataPtr = img.qImg().constBits();
+
+    EXPECT_FALSE(img.detach());
+    EXPECT_THAT(img.mutableBits(), Eq(dataPtr));
+    ASSERT_THAT(QCVimgCore::copyStats().detaches, Eq(0u));
+}
+
+TEST_F(QCVimgDetach, MutableBitsOfSharedImagePointToMatData)
+{
+    QImage sharingQImg = img.qImg();
+
+    uchar* data = img.mutableBits();
+
+    ASSERT_THAT(data, Eq(img.cvMat().data));
+}
+
+TEST_F(QCVimgDetach, CopyConstructionIsCountedAsDeepCopy)
+{
+    QCVimgCore copiedImg(img);
+
+    ASSERT_THAT(QCVimgCore::copyStats().deepCopies, Eq(1u));
+}
+
+TEST_F(QCVimgDetach, CopyIntoSameSizedImageIsCountedAsDeepCopy)
+{
+    cv::Mat sourceMat(4, 6, CV_8UC3, cv::Scalar(1, 2, 3));
+
+    img.copy(sourceMat);
+
+    EXPECT_THAT(QCVimgCore::copyStats().detaches, Eq(0u));
+    ASSERT_THAT(QCVimgCore::copyStats().deepCopies, Eq(1u));
+}
+
+struct QCVimgShare : public QCVimgDetach
+{
+};
+
+TEST_F(QCVimgShare, SharedHandleReferencesImageDataWithoutCopying)
+{
+    QCVimgConstRef ref = img.share();
+
+    EXPECT_THAT(ref.qImg().constBits(), Eq(std::as_const(img).qImg().constBits()));
+    EXPECT_THAT(ref.cvMat().data, Eq(ref.qImg().constBits()));
+    EXPECT_THAT(QCVimgCore::copyStats().detaches, Eq(0u));
+    ASSERT_THAT(QCVimgCore::copyStats().deepCopies, Eq(0u));
+}
+
+TEST_F(QCVimgShare, ModifyingOriginalImageLeavesSharedHandleUnchanged)
+{
+    img.fill(Qt::red);
+    QCVimgConstRef ref = img.share();
+
+    img.cvMat().setTo(cv::Scalar(0, 0, 255));
+
+    EXPECT_TRUE(img.isMatBound());
+    EXPECT_THAT(ref.cvMat().at<cv::Vec3b>(1,1)[0], Eq(255));
+    ASSERT_THAT(img.cvMat().at<cv::Vec3b>(1,1)[0], Eq(0));
+}
+
+TEST_F(QCVimgShare, SharedHandleOutlivesOriginalImage)
+{
+    img.fill(Qt::blue);
+    QCVimgConstRef ref;
+
+    {
+        QCVimgCore scopedImg(img);
+        ref = scopedImg.share();
+    }
+
+    ASSERT_THAT(ref.copy().pixelColor(1,1), Eq(QColor(Qt::blue)));
+}
+
+struct QCVimgDeviceResident : public Test
+{
+    void SetUp() override {
+        img.fill(QColor(20, 40, 60));
+    }
+
+    QCVimgCore img{16, 12, QImage::Format_RGB888};
+};
+
+TEST_F(QCVimgDeviceResident, UploadedImageIsDeviceResident)
+{
+    EXPECT_FALSE(img.isDeviceResident());
+
+    int returnCode = img.upload();
+
+    EXPECT_THAT(returnCode, Eq(0));
+    ASSERT_TRUE(img.isDeviceResident());
+}
+
+TEST_F(QCVimgDeviceResident, ModificationThroughUMatIsVisibleInQImage)
+{
+    img.uMat().setTo(cv::Scalar(90, 80, 70));
+
+    ASSERT_THAT(img.pixelColor(2, 2), Eq(QColor(90, 80, 70)));
+}
+
+TEST_F(QCVimgDeviceResident, DeviceResizeAndConversionMatchHostResults)
+{
+    QCVimgCore hostResult = img.resize(8, 6, ResizeInterpolation::Area).convertToFormat(QImage::Format_ARGB32);
+    img.upload();
+
+    QCVimgCore deviceResult = img.resize(8, 6, ResizeInterpolation::Area).convertToFormat(QImage::Format_ARGB32);
+
+    EXPECT_TRUE(deviceResult.isDeviceResident());
+    ASSERT_TRUE(deviceResult == hostResult);
+}
+
+TEST_F(QCVimgDeviceResident, ModifyingHostDataReleasesDeviceCopy)
+{
+    img.upload();
+
+    img.fill(Qt::red);
+
+    EXPECT_FALSE(img.isDeviceResident());
+    const QCVimgCore& constImg = img;
+    ASSERT_THAT(constImg.uMat().getMat(cv::ACCESS_READ).at<cv::Vec3b>(1, 1)[0], Eq(255));
+}
+
+struct QCVimgInstrumentation : public Test
+{
+    void SetUp() override {
+        QCVimgStats::reset();
+        sHookCalls = 0;
+    }
+
+    void TearDown() override {
+        QCVimgStats::setHook(nullptr);
+        QCVimgStats::setTimersEnabled(false);
+    }
+
+    static void countHookCalls(QCVimgStats::Event, quint64, quint64) {
+        ++sHookCalls;
+    }
+
+    static int sHookCalls;
+    QCVimgCore img{6, 4, QImage::Format_RGB888};
+};
+
+int QCVimgInstrumentation::sHookCalls = 0;
+
+TEST_F(QCVimgInstrumentation, DeepCopyIsCountedWithItsSizeIfEnabled)
+{
+    QCVimgCore copiedImg(img);
+    const quint64 expectedCount = QCVimgStats::enabled() ? 1 : 0;
+
+    QCVimgStats::Snapshot stats = QCVimgCore::stats();
+
+    EXPECT_THAT(stats.deepCopies.count, Eq(expectedCount));
+    ASSERT_THAT(stats.deepCopies.bytes, Eq(expectedCount * static_cast<quint64>(img.bytes())));
+}
+
+TEST_F(QCVimgInstrumentation, RecordedOperationsAreSummedAndReportedToHook)
+{
+    QCVimgStats::setHook(countHookCalls);
+
+    QCVimgStats::record(QCVimgStats::Event::Swizzle, 100);
+    QCVimgStats::record(QCVimgStats::Event::Swizzle, 20);
+    QCVimgStats::recordTime(QCVimgStats::Event::Swizzle, 7);
+
+    QCVimgStats::Snapshot stats = QCVimgStats::threadSnapshot();
+    EXPECT_THAT(stats.swizzles.count, Eq(2u));
+    EXPECT_THAT(stats.swizzles.bytes, Eq(120u));
+    EXPECT_THAT(stats.counter(QCVimgStats::Event::Swizzle).nanoseconds, Eq(7u));
+    ASSERT_THAT(sHookCalls, Eq(3));
+}
+
+TEST_F(QCVimgInstrumentation, ResetClearsAllCounters)
+{
+    QCVimgStats::record(QCVimgStats::Event::Rebind, 10);
+
+    QCVimgStats::reset();
+
+    ASSERT_THAT(QCVimgStats::snapshot().rebinds.count, Eq(0u));
+}
+
 struct QCVimgRebindMembers : public Test
 {
     void SetUp() override {
@@ -717,6 +1173,45 @@ TEST_F(QCVimgRebindQImage, SetsMatAndQImageMemberEmptyOnIncompatibleMatFormatAnd
     ASSERT_TRUE(img.empty());
 }
 
+TEST_F(QCVimgRebindQImage, AdoptsExclusivelyOwnedMatWithoutCopy)
+{
+    img.cvMat() = cv::Mat(originalHeight, originalWidth, CV_8UC3, cv::Scalar(110, 50, 20));
+    auto matDataPtr = img.cvMat().data;
+
+    img.rebindQImg();
+
+    EXPECT_THAT(img.qImg().constBits(), Eq(matDataPtr));
+    ASSERT_TRUE(img.isMatBound());
+}
+
+TEST_F(QCVimgRebindQImage, LazyRebindCopiesDataOnFirstAccess)
+{
+    cv::Mat sourceMat(originalHeight, originalWidth, CV_8UC3, cv::Scalar(20, 50, 110));
+    img.setBindingMode(BindingMode::Lazy);
+    img.cvMat() = sourceMat;
+    auto deepCopiesBeforeRebind = QCVimg::copyStats().deepCopies;
+
+    img.rebindQImg(DataPrio::Low, MatColorOrder::BGR);
+
+    EXPECT_THAT(QCVimg::copyStats().deepCopies, Eq(deepCopiesBeforeRebind));
+    EXPECT_TRUE(img.isMatBound());
+    EXPECT_THAT(img.pixelColor(1, 1), Eq(QColor(110, 50, 20)));
+    ASSERT_THAT(img.cvMat().at<cv::Vec3b>(0, 0), Eq(cv::Vec3b(110, 50, 20)));
+}
+
+TEST_F(QCVimgRebindQImage, PostponedDataIsDroppedWhenImageIsOverwritten)
+{
+    QCVimg sourceImg(originalWidth, originalHeight, QImage::Format_Grayscale8);
+    sourceImg.fill(QColor(40, 40, 40));
+    img.setBindingMode(BindingMode::Lazy);
+    img.cvMat() = matCompatImg;
+    img.rebindQImg();
+
+    sourceImg.convertInto(img, QImage::Format_Grayscale8);
+
+    ASSERT_THAT(qGray(img.pixelColor(0, 0).rgb()), Eq(40));
+}
+
 struct QCVimgCompare : public Test
 {
     void SetUp() override
@@ -752,23 +1247,91 @@ TEST_F(QCVimgCompare, QCVimgsNotEqualIfMatMembersAreNotBound)
     ASSERT_THAT(qcvimgCompare, Eq(matBoundCompare));
 }
 
-struct QCVimgResizeImage : public Test
+TEST_F(QCVimgCompare, EqualImagesHaveEqualHashes)
 {
-    void SetUp() override {
-        QImage qOrigImg = QImage(originalWidth, originalHeight, originalFormat);
-        qOrigImg.fill(originalFillColor);
-        img = QCVimg(qOrigImg);
-    }
+    img.fill(77);
+    copyImg = img;
 
-    QCVimg img;
-    int originalWidth = 15, originalHeight = 10;
-    int resizedWidth = 30, resizedHeight = 40;
-    uint32_t originalFillColor = 150;
-    QImage::Format originalFormat = QImage::Format_Grayscale8;
-};
+    ASSERT_TRUE(img == copyImg);
+    ASSERT_THAT(img.hash(), Eq(copyImg.hash()));
+}
 
-TEST_F(QCVimgResizeImage, ResizedQImageMemberReturnsNewSize) {
-    QCVimg resizedImg = img.resize(resizedWidth, resizedHeight);
+TEST_F(QCVimgCompare, QCVimgsNotEqualIfSinglePixelDiffers)
+{
+    img.fill(77);
+    copyImg = img;
+    copyImg.cvMat().at<uchar>(originalHeight - 1, originalWidth - 1) = 78;
+
+    ASSERT_FALSE(img == copyImg);
+}
+
+TEST_F(QCVimgCompare, ScanlinePaddingIsIgnored)
+{
+    // Five Grayscale8 pixels leave three bytes of padding per scanline
+    QCVimg paddedImg(5, 3, QImage::Format_Grayscale8);
+    paddedImg.fill(20);
+    QCVimg paddedCopy(paddedImg);
+    uchar* bits = paddedCopy.mutableBits();
+
+    for (int row = 0; row < 3; ++row) {
+        bits[row * paddedCopy.qImg().bytesPerLine() + 5] = 0xab;
+    }
+
+    ASSERT_TRUE(paddedImg == paddedCopy);
+    ASSERT_THAT(paddedImg.hash(), Eq(paddedCopy.hash()));
+}
+
+TEST_F(QCVimgCompare, UnusedByteOfRgb32IsIgnored)
+{
+    QCVimg rgbImg(6, 4, QImage::Format_RGB32);
+    rgbImg.fill(QColor(10, 20, 30));
+    QCVimg rgbCopy(rgbImg);
+    rgbCopy.cvMat().at<cv::Vec4b>(2, 3)[3] = 0x12;
+
+    ASSERT_TRUE(rgbImg == rgbCopy);
+    ASSERT_THAT(rgbImg.hash(), Eq(rgbCopy.hash()));
+}
+
+TEST_F(QCVimgCompare, StaleCachedHashDoesNotAffectEquality)
+{
+    img.fill(77);
+    copyImg.fill(78);
+    cv::Mat& copyMat = copyImg.cvMat();
+    copyImg.hash(HashCaching::Enabled);
+    img.hash(HashCaching::Enabled);
+
+    copyMat.setTo(77);
+
+    ASSERT_TRUE(img == copyImg);
+}
+
+TEST_F(QCVimgCompare, CachedHashIsUpdatedAfterModification)
+{
+    img.fill(77);
+    const size_t hashBeforeFill = img.hash(HashCaching::Enabled);
+    img.fill(78);
+
+    ASSERT_THAT(img.hash(HashCaching::Enabled), Ne(hashBeforeFill));
+    ASSERT_THAT(img.hash(HashCaching::Enabled), Eq(img.hash()));
+}
+
+struct QCVimgResizeImage : public Test
+{
+    void SetUp() override {
+        QImage qOrigImg = QImage(originalWidth, originalHeight, originalFormat);
+        qOrigImg.fill(originalFillColor);
+        img = QCVimg(qOrigImg);
+    }
+
+    QCVimg img;
+    int originalWidth = 15, originalHeight = 10;
+    int resizedWidth = 30, resizedHeight = 40;
+    uint32_t originalFillColor = 150;
+    QImage::Format originalFormat = QImage::Format_Grayscale8;
+};
+
+TEST_F(QCVimgResizeImage, ResizedQImageMemberReturnsNewSize) {
+    QCVimg resizedImg = img.resize(resizedWidth, resizedHeight);
 
     ASSERT_THAT(resizedImg.qImg().width(), resizedWidth);
     ASSERT_THAT(resizedImg.qImg().height(), resizedHeight);
@@ -782,6 +1345,52 @@ TEST_F(QCVimgResizeImage, ResizedMatMemberReturnsNewSize)
     ASSERT_THAT(resizedImg.cvMat().rows, Eq(resizedHeight));
 }
 
+TEST_F(QCVimgResizeImage, ResizedIntoDestImageHasNewSizeAndOriginalData)
+{
+    QCVimg destImg;
+
+    int returnCode = img.resizeInto(destImg, resizedWidth, resizedHeight);
+
+    EXPECT_THAT(returnCode, Eq(0));
+    EXPECT_THAT(destImg.width(), Eq(resizedWidth));
+    EXPECT_THAT(destImg.height(), Eq(resizedHeight));
+    EXPECT_TRUE(destImg.isMatBound());
+    ASSERT_THAT(destImg.cvMat().at<uint8_t>(1,1), Eq(originalFillColor));
+}
+
+TEST_F(QCVimgResizeImage, ResizingIntoMatchingDestImageReusesItsBuffer)
+{
+    QCVimg destImg(resizedWidth, resizedHeight, originalFormat);
+    auto destDataPtr = destImg.qImg().constBits();
+
+    img.resizeInto(destImg, resizedWidth, resizedHeight, ResizeInterpolation::Linear);
+
+    ASSERT_THAT(destImg.qImg().constBits(), Eq(destDataPtr));
+}
+
+TEST_F(QCVimgResizeImage, ResizingIntoDestImageKeepsAspectRatioIfRequested)
+{
+    QCVimg destImg;
+
+    img.resizeInto(destImg, resizedWidth, resizedHeight, ResizeInterpolation::Cubic, Qt::KeepAspectRatio);
+
+    EXPECT_THAT(destImg.width(), Eq(resizedWidth));
+    ASSERT_THAT(destImg.height(), Eq(resizedWidth * originalHeight / originalWidth));
+}
+
+TEST_F(QCVimgResizeImage, ResizingIntoItselfIsRejected)
+{
+    ASSERT_THAT(img.resizeInto(img, resizedWidth, resizedHeight), Eq(-1));
+}
+
+TEST_F(QCVimgResizeImage, OpenCVResizedImageReturnsNewSize)
+{
+    QCVimg resizedImg = img.resize(resizedWidth, resizedHeight, ResizeInterpolation::Area);
+
+    EXPECT_THAT(resizedImg.cvMat().cols, Eq(resizedWidth));
+    ASSERT_THAT(resizedImg.cvMat().rows, Eq(resizedHeight));
+}
+
 struct QCVimgSwap : public Test
 {
     QCVimg firstImg, secondImg;
@@ -941,6 +1550,247 @@ TEST_P(QCVimgChangeFormat2, ReturnsEmptyImageOnIncompatibleFormat)
 }
 INSTANTIATE_TEST_SUITE_P(QCVimg_BulkTest, QCVimgChangeFormat2, ValuesIn(invalidFormatConversions));
 
+struct QCVimgChangeFormat3 : public QCVimgChangeFormat
+{
+};
+
+QCVimgChangeFormatCase colorPreservingFormatConversions[] = {
+    QCVimgChangeFormatCase(QImage::Format_RGB888, QImage::Format_ARGB32),
+    QCVimgChangeFormatCase(QImage::Format_RGB888, QImage::Format_RGB32),
+    QCVimgChangeFormatCase(QImage::Format_ARGB32, QImage::Format_RGB888),
+    QCVimgChangeFormatCase(QImage::Format_RGB32, QImage::Format_ARGB32),
+    QCVimgChangeFormatCase(QImage::Format_ARGB32, QImage::Format_RGB32)
+};
+
+TEST_P(QCVimgChangeFormat3, ConvertedImageKeepsPixelColors)
+{
+    QCVimgChangeFormatCase testCase = GetParam();
+    QColor fillColor = qRgb(200, 120, 40);
+
+    qImg = QImage(originalWidth, originalHeight, testCase.originalFormat);
+    qImg.fill(fillColor);
+    origImg = QCVimg(qImg);
+
+    convertedImg = origImg.convertToFormat(testCase.expectedFormat);
+
+    EXPECT_TRUE(convertedImg.isMatBound());
+    ASSERT_THAT(convertedImg.pixelColor(1,1).rgb(), Eq(fillColor.rgb()));
+}
+INSTANTIATE_TEST_SUITE_P(QCVimg_BulkTest, QCVimgChangeFormat3, ValuesIn(colorPreservingFormatConversions));
+
+TEST(QCVimgChangeFormatGray, Grayscale16ConvertsToGrayscale8)
+{
+    QCVimg img(cv::Mat(4, 6, CV_16UC1, cv::Scalar(257 * 90)));
+
+    QCVimg convertedImg = img.convertToFormat(QImage::Format_Grayscale8);
+
+    ASSERT_THAT(convertedImg.cvMat().at<uint8_t>(1,1), Eq(90));
+}
+
+TEST(QCVimgChangeFormatGray, RGB888ConvertsToGrayscale8LikeQImage)
+{
+    QImage qImg(6, 4, QImage::Format_RGB888);
+    qImg.fill(qRgb(200, 120, 40));
+    QCVimg img(qImg);
+
+    QCVimg convertedImg = img.convertToFormat(QImage::Format_Grayscale8);
+
+    ASSERT_NEAR(convertedImg.cvMat().at<uint8_t>(1,1), qGray(qRgb(200, 120, 40)), 1);
+}
+
+struct QCVimgConvertInPlace : public Test
+{
+    void SetUp() override {
+        img = QCVimg(originalWidth, originalHeight, QImage::Format_ARGB32);
+        img.fill(fillColor);
+    }
+
+    QCVimg img;
+    QColor fillColor = qRgb(20, 140, 220);
+    int originalWidth = 9, originalHeight = 5;
+};
+
+TEST_F(QCVimgConvertInPlace, ConvertsToCompatibleFormatAndRebindsMat)
+{
+    int returnCode = img.convertTo(QImage::Format_RGB888);
+
+    EXPECT_THAT(returnCode, Eq(0));
+    EXPECT_THAT(img.qFormat(), Eq(QImage::Format_RGB888));
+    EXPECT_TRUE(img.isMatBound());
+    ASSERT_THAT(img.pixelColor(1,1).rgb(), Eq(fillColor.rgb()));
+}
+
+TEST_F(QCVimgConvertInPlace, ReusesBufferIfPixelSizeDoesNotChange)
+{
+    auto dataPtrBeforeConversion = img.qImg().constBits();
+
+    img.convertTo(QImage::Format_RGB32);
+
+    ASSERT_THAT(img.qImg().constBits(), Eq(dataPtrBeforeConversion));
+}
+
+TEST_F(QCVimgConvertInPlace, LeavesImageUnchangedOnIncompatibleFormat)
+{
+    int returnCode = img.convertTo(QImage::Format_Mono);
+
+    EXPECT_THAT(returnCode, Eq(-1));
+    ASSERT_THAT(img.qFormat(), Eq(QImage::Format_ARGB32));
+}
+
+TEST_F(QCVimgConvertInPlace, FailsOnEmptyImage)
+{
+    QCVimgCore emptyImg;
+
+    EXPECT_THAT(emptyImg.convertTo(QImage::Format_RGB888), Eq(-1));
+    EXPECT_TRUE(emptyImg.cvMat().empty());
+    ASSERT_THAT(emptyImg.qFormat(), Eq(QImage::Format_Invalid));
+}
+
+TEST_F(QCVimgConvertInPlace, ConvertingIntoMatchingDestImageReusesItsBuffer)
+{
+    QCVimg destImg(originalWidth, originalHeight, QImage::Format_RGB888);
+    auto destDataPtr = destImg.qImg().constBits();
+
+    int returnCode = img.convertInto(destImg, QImage::Format_RGB888);
+
+    EXPECT_THAT(returnCode, Eq(0));
+    EXPECT_THAT(destImg.qImg().constBits(), Eq(destDataPtr));
+    ASSERT_THAT(destImg.pixelColor(1,1).rgb(), Eq(fillColor.rgb()));
+}
+
+TEST_F(QCVimgConvertInPlace, ConvertingIntoMismatchingDestImageReallocatesIt)
+{
+    QCVimg destImg;
+
+    img.convertInto(destImg, QImage::Format_Grayscale8);
+
+    EXPECT_THAT(destImg.qFormat(), Eq(QImage::Format_Grayscale8));
+    EXPECT_THAT(destImg.width(), Eq(originalWidth));
+    ASSERT_TRUE(destImg.isMatBound());
+}
+
+struct QCVimgBatchConstruct : public Test
+{
+    void SetUp() override {
+        for (int i = 0; i < frameCount; ++i) {
+            mats.emplace_back(frameHeight, frameWidth, CV_8UC3, cv::Scalar(i, 100, 200));
+        }
+    }
+
+    std::vector<cv::Mat> mats;
+    int frameCount = 5, frameWidth = 7, frameHeight = 3;
+};
+
+TEST_F(QCVimgBatchConstruct, CreatesBoundFrameForEachMat)
+{
+    QCVimgBatch batch = QCVimgBatch::fromMats(mats);
+
+    ASSERT_THAT(batch.size(), Eq(frameCount));
+    EXPECT_THAT(batch.format(), Eq(QImage::Format_RGB888));
+
+    for (int i = 0; i < batch.size(); ++i) {
+        EXPECT_TRUE(batch.frame(i).isMatBound());
+        ASSERT_THAT(batch.frame(i).cvMat().at<cv::Vec3b>(1,1)[0], Eq(i));
+    }
+}
+
+TEST_F(QCVimgBatchConstruct, SourceMatsWithBGRColorOrderConvertToRGB)
+{
+    QCVimgBatch batch = QCVimgBatch::fromMats(mats, MatColorOrder::BGR);
+
+    cv::Vec3b frameColor = batch.frame(frameCount - 1).cvMat().at<cv::Vec3b>(1,1);
+
+    EXPECT_THAT(frameColor[0], Eq(200));
+    ASSERT_THAT(frameColor[2], Eq(frameCount - 1));
+}
+
+TEST_F(QCVimgBatchConstruct, BlobViewsAllFramesContiguously)
+{
+    QCVimgBatch batch = QCVimgBatch::fromMats(mats);
+
+    cv::Mat blob = batch.blob();
+
+    ASSERT_THAT(blob.dims, Eq(3));
+    EXPECT_THAT(blob.size[0], Eq(frameCount));
+    EXPECT_THAT(blob.size[1], Eq(frameHeight));
+    EXPECT_THAT(blob.size[2], Eq(frameWidth));
+    ASSERT_THAT(blob.ptr(1), Eq(batch.frame(1).qImg().constBits()));
+}
+
+TEST_F(QCVimgBatchConstruct, MismatchingMatSizesReturnEmptyBatch)
+{
+    mats.emplace_back(frameHeight + 1, frameWidth, CV_8UC3);
+
+    QCVimgBatch batch = QCVimgBatch::fromMats(mats);
+
+    ASSERT_TRUE(batch.empty());
+}
+
+TEST_F(QCVimgBatchConstruct, ImagesConvertToRequestedFormat)
+{
+    std::vector<QCVimg> images(mats.begin(), mats.end());
+
+    QCVimgBatch batch = QCVimgBatch::fromImages(images, QImage::Format_ARGB32);
+
+    ASSERT_THAT(batch.size(), Eq(frameCount));
+    EXPECT_THAT(batch.frame(0).qFormat(), Eq(QImage::Format_ARGB32));
+    ASSERT_THAT(batch.frame(2).pixelColor(1,1).rgb(), Eq(qRgb(2, 100, 200)));
+}
+
+struct QCVimgFillRegion : public Test
+{
+    void SetUp() override {
+        img.fill(Qt::white);
+    }
+
+    QCVimg img{12, 8, QImage::Format_RGB888};
+    QRect fillRect{2, 3, 5, 4};
+    QColor fillColor = qRgb(10, 120, 230);
+};
+
+TEST_F(QCVimgFillRegion, FillingRegionLeavesRestOfImageUntouched)
+{
+    img.fill(fillColor, fillRect);
+
+    EXPECT_THAT(img.pixelColor(fillRect.left(), fillRect.top()).rgb(), Eq(fillColor.rgb()));
+    EXPECT_THAT(img.pixelColor(fillRect.right(), fillRect.bottom()).rgb(), Eq(fillColor.rgb()));
+    EXPECT_THAT(img.pixelColor(fillRect.right() + 1, fillRect.top()).rgb(), Eq(QColor(Qt::white).rgb()));
+    ASSERT_THAT(img.pixelColor(fillRect.left(), fillRect.top() - 1).rgb(), Eq(QColor(Qt::white).rgb()));
+}
+
+TEST_F(QCVimgFillRegion, FillingWithScalarRespectsColorOrder)
+{
+    cv::Scalar bgrValue = QCVimg::convertQColorToScalar(fillColor, MatColorOrder::BGR);
+
+    int returnCode = img.fill(bgrValue, MatColorOrder::BGR, fillRect);
+
+    EXPECT_THAT(returnCode, Eq(0));
+    ASSERT_THAT(img.pixelColor(fillRect.left(), fillRect.top()).rgb(), Eq(fillColor.rgb()));
+}
+
+TEST_F(QCVimgFillRegion, FillingArgbImageWithScalarMatchesQColorFill)
+{
+    QCVimg argbImg(12, 8, QImage::Format_ARGB32);
+    cv::Scalar rgbaValue = QCVimg::convertQColorToScalar(fillColor, MatColorOrder::RGB);
+    rgbaValue[3] = 255;
+
+    argbImg.fill(rgbaValue, MatColorOrder::RGB);
+
+    ASSERT_THAT(argbImg.pixelColor(5,5).rgba(), Eq(fillColor.rgba()));
+}
+
+TEST(QCVimgFillLarge, LargeImageIsFilledCompletely)
+{
+    QCVimg img(2048, 1536, QImage::Format_RGB888);
+    QColor fillColor = qRgb(1, 2, 3);
+
+    img.fill(fillColor);
+
+    EXPECT_THAT(img.pixelColor(0, 0).rgb(), Eq(fillColor.rgb()));
+    EXPECT_THAT(img.pixelColor(1023, 777).rgb(), Eq(fillColor.rgb()));
+    ASSERT_THAT(img.pixelColor(2047, 1535).rgb(), Eq(fillColor.rgb()));
+}
+
 struct QCVimgCopyFromImg : public Test
 {
     void SetUp() override {
@@ -1105,4 +1955,1147 @@ TEST_P(QCVimgSerialization, OriginalImageDataIsUnchangedAfterSerialization)
 
     ASSERT_THAT(destImg, Eq(sourceImgCase));
 }
+
+TEST_P(QCVimgSerialization, OriginalImageDataIsUnchangedAfterPngSerialization)
+{
+    QCVimg sourceImgCase = GetParam();
+    sourceImgCase.fill(Qt::gray);
+    QCVimg destImg;
+
+    buffer.open(QIODevice::WriteOnly);
+    int returnCode = sourceImgCase.writeTo(dataStream, StreamEncoding::Png);
+    buffer.close();
+
+    buffer.open(QIODevice::ReadOnly);
+    dataStream >> destImg;
+
+    EXPECT_THAT(returnCode, Eq(0));
+    ASSERT_THAT(destImg, Eq(sourceImgCase));
+}
 INSTANTIATE_TEST_SUITE_P(QCVimg_BulkTest, QCVimgSerialization, ValuesIn(imageFormatCases));
+
+struct QCVimgRawSerialization : public QCVimgSerialization
+{
+    QCVimg sourceImg{8, 4, QImage::Format_RGB888};
+};
+
+TEST_F(QCVimgRawSerialization, PngStreamReplacesLazilyBoundImage)
+{
+    sourceImg.fill(Qt::gray);
+    QCVimg destImg(cv::Mat(4, 8, CV_8UC3, cv::Scalar(1, 2, 3)), MatColorOrder::BGR, BindingMode::Lazy);
+
+    buffer.open(QIODevice::WriteOnly);
+    sourceImg.writeTo(dataStream, StreamEncoding::Png);
+    buffer.close();
+
+    buffer.open(QIODevice::ReadOnly);
+    dataStream >> destImg;
+
+    EXPECT_TRUE(destImg.isMatBound());
+    ASSERT_THAT(destImg, Eq(sourceImg));
+}
+
+TEST_F(QCVimgRawSerialization, DeserializingIntoMatchingImageReusesItsBuffer)
+{
+    QCVimg destImg(8, 4, QImage::Format_RGB888);
+    auto destDataPtr = destImg.qImg().constBits();
+    sourceImg.fill(Qt::darkCyan);
+
+    buffer.open(QIODevice::WriteOnly);
+    dataStream << sourceImg;
+    buffer.close();
+
+    buffer.open(QIODevice::ReadOnly);
+    dataStream >> destImg;
+
+    EXPECT_THAT(destImg.qImg().constBits(), Eq(destDataPtr));
+    EXPECT_TRUE(destImg.isMatBound());
+    ASSERT_THAT(destImg, Eq(sourceImg));
+}
+
+TEST_F(QCVimgRawSerialization, TruncatedDataReturnsEmptyImage)
+{
+    QCVimg destImg;
+
+    buffer.open(QIODevice::WriteOnly);
+    dataStream << sourceImg;
+    buffer.close();
+    buffer.buffer().chop(5);
+
+    buffer.open(QIODevice::ReadOnly);
+    dataStream >> destImg;
+
+    EXPECT_THAT(dataStream.status(), Ne(QDataStream::Ok));
+    ASSERT_TRUE(destImg.empty());
+}
+
+TEST_F(QCVimgRawSerialization, EmptyImageRoundTripsAsEmptyImage)
+{
+    QCVimg emptyImg, destImg(8, 4, QImage::Format_RGB888);
+
+    buffer.open(QIODevice::WriteOnly);
+    dataStream << emptyImg;
+    buffer.close();
+
+    buffer.open(QIODevice::ReadOnly);
+    dataStream >> destImg;
+
+    EXPECT_THAT(dataStream.status(), Eq(QDataStream::Ok));
+    ASSERT_TRUE(destImg.empty());
+}
+
+struct QCVimgMapFile : public Test
+{
+    void SetUp() override {
+        sourceImg.fill(Qt::darkMagenta);
+
+        file.open();
+        QDataStream dataStream(&file);
+        dataStream << sourceImg;
+        file.close();
+    }
+
+    QTemporaryFile file;
+    QCVimg sourceImg{9, 5, QImage::Format_RGB888};
+};
+
+TEST_F(QCVimgMapFile, MappedImageMatchesSerializedImage)
+{
+    QCVimg mappedImg = QCVimg::mapFile(file.fileName());
+
+    EXPECT_TRUE(mappedImg.isMatBound());
+    ASSERT_THAT(mappedImg, Eq(sourceImg));
+}
+
+TEST_F(QCVimgMapFile, ModifyingPrivatelyMappedImageLeavesFileUnchanged)
+{
+    QCVimg mappedImg = QCVimg::mapFile(file.fileName());
+    mappedImg.fill(Qt::yellow);
+
+    QCVimg remappedImg = QCVimg::mapFile(file.fileName());
+
+    ASSERT_THAT(remappedImg, Eq(sourceImg));
+}
+
+TEST_F(QCVimgMapFile, FileWithoutRawHeaderReturnsEmptyImage)
+{
+    file.open();
+    file.resize(0);
+    file.write("no image here");
+    file.close();
+
+    QCVimg mappedImg = QCVimg::mapFile(file.fileName());
+
+    ASSERT_TRUE(mappedImg.empty());
+}
+
+TEST(QCVimgSharedMemory, ImageWrittenBySharedMemoryOwnerIsVisibleToAttachedImage)
+{
+    QSharedMemory ownerMemory("QCVimgSharedMemoryTest");
+    QSharedMemory attachedMemory("QCVimgSharedMemoryTest");
+    ASSERT_TRUE(ownerMemory.create(static_cast<int>(QCVimg::rawSize(6, 4, QImage::Format_Grayscale8))));
+    ASSERT_TRUE(attachedMemory.attach());
+
+    QCVimg ownerImg = QCVimg::fromSharedMemory(ownerMemory, 6, 4, QImage::Format_Grayscale8);
+    ownerImg.cvMat().setTo(cv::Scalar(77));
+    QCVimg attachedImg = QCVimg::fromSharedMemory(attachedMemory);
+
+    EXPECT_THAT(attachedImg.width(), Eq(6));
+    EXPECT_THAT(attachedImg.qFormat(), Eq(QImage::Format_Grayscale8));
+    ASSERT_THAT(attachedImg.cvMat().at<uint8_t>(1,1), Eq(77));
+}
+
+struct QCVimgPoolAcquire : public Test
+{
+    QCVimgPool pool;
+    int originalWidth = 37, originalHeight = 11;
+    QImage::Format originalFormat = QImage::Format_RGB888;
+};
+
+TEST_F(QCVimgPoolAcquire, AcquiredImageHasRequestedSizeAndFormat)
+{
+    QCVimg img = pool.acquire(originalWidth, originalHeight, originalFormat);
+
+    EXPECT_THAT(img.width(), Eq(originalWidth));
+    EXPECT_THAT(img.height(), Eq(originalHeight));
+    EXPECT_THAT(img.qFormat(), Eq(originalFormat));
+    ASSERT_TRUE(img.isMatBound());
+}
+
+TEST_F(QCVimgPoolAcquire, AcquiredImageDataAndScanlinesAreAligned)
+{
+    QCVimg img = pool.acquire(originalWidth, originalHeight, originalFormat);
+
+    auto dataAddress = reinterpret_cast<quintptr>(img.qImg().constBits());
+
+    EXPECT_THAT(dataAddress % QCVimgPool::scmBufferAlignment, Eq(0u));
+    ASSERT_THAT(img.qImg().bytesPerLine() % QCVimgPool::scmBufferAlignment, Eq(0));
+}
+
+TEST_F(QCVimgPoolAcquire, ReleasedBufferIsReusedForMatchingRequest)
+{
+    const uchar* firstDataPtr = nullptr;
+    {
+        QCVimg img = pool.acquire(originalWidth, originalHeight, originalFormat);
+        firstDataPtr = img.qImg().constBits();
+    }
+
+    EXPECT_THAT(pool.cachedBuffers(), Eq(1));
+
+    QCVimg img = pool.acquire(originalWidth, originalHeight, originalFormat);
+
+    EXPECT_THAT(img.qImg().constBits(), Eq(firstDataPtr));
+    ASSERT_THAT(pool.cachedBuffers(), Eq(0));
+}
+
+TEST_F(QCVimgPoolAcquire, ReleasedBufferIsNotReusedForDifferentFormat)
+{
+    {
+        QCVimg img = pool.acquire(originalWidth, originalHeight, originalFormat);
+    }
+
+    QCVimg img = pool.acquire(originalWidth, originalHeight, QImage::Format_Grayscale8);
+
+    ASSERT_THAT(pool.cachedBuffers(), Eq(1));
+}
+
+TEST_F(QCVimgPoolAcquire, ReturnsEmptyImageOnIncompatibleFormat)
+{
+    QCVimg img = pool.acquire(originalWidth, originalHeight, QImage::Format_Mono);
+
+    ASSERT_TRUE(img.empty());
+}
+
+TEST_F(QCVimgPoolAcquire, AcquiredImageCanOutliveThePool)
+{
+    auto tempPool = std::make_unique<QCVimgPool>();
+    QCVimg img = tempPool->acquire(originalWidth, originalHeight, originalFormat);
+    img.fill(Qt::red);
+
+    tempPool.reset();
+
+    ASSERT_THAT(img.pixelColor(1,1).rgb(), Eq(QColor(Qt::red).rgb()));
+}
+
+struct SwapRedBlueCase
+{
+    SwapRedBlueCase(int argMatFormat, int argWidth)
+        : matFormat{argMatFormat}, width{argWidth} {}
+
+    int matFormat;
+    int width;
+};
+
+struct QCVimgSwapMatRedBlue : public TestWithParam<SwapRedBlueCase>
+{
+    void SetUp() override {
+        SwapRedBlueCase testCase = GetParam();
+        sourceMat = cv::Mat(originalHeight, testCase.width, testCase.matFormat, cv::Scalar(10, 20, 30, 40));
+    }
+
+    cv::Mat sourceMat;
+    int originalHeight = 5;
+};
+
+// Widths are chosen so that both the vectorized and the scalar tail code paths are exercised
+SwapRedBlueCase swapRedBlueCases[] = {
+    SwapRedBlueCase(CV_8UC3, 1),
+    SwapRedBlueCase(CV_8UC3, 37),
+    SwapRedBlueCase(CV_8UC4, 3),
+    SwapRedBlueCase(CV_8UC4, 41)
+};
+
+TEST_P(QCVimgSwapMatRedBlue, RedAndBlueChannelsAreSwappedOtherChannelsUnchanged)
+{
+    cv::Mat destMat;
+
+    int returnCode = QCVimg::swapMatRedBlue(sourceMat, destMat);
+
+    std::vector<cv::Mat> destChannels;
+    cv::split(destMat, destChannels);
+
+    EXPECT_THAT(returnCode, Eq(0));
+    EXPECT_THAT(cv::countNonZero(destChannels[0] != 30), Eq(0));
+    EXPECT_THAT(cv::countNonZero(destChannels[1] != 20), Eq(0));
+    ASSERT_THAT(cv::countNonZero(destChannels[2] != 10), Eq(0));
+    if (destMat.channels() == 4) {
+        ASSERT_THAT(cv::countNonZero(destChannels[3] != 40), Eq(0));
+    }
+}
+
+TEST_P(QCVimgSwapMatRedBlue, SwapsInPlaceWithoutReallocation)
+{
+    auto dataPtrBeforeSwap = sourceMat.data;
+
+    QCVimg::swapMatRedBlue(sourceMat, sourceMat);
+
+    std::vector<cv::Mat> channels;
+    cv::split(sourceMat, channels);
+
+    EXPECT_THAT(sourceMat.data, Eq(dataPtrBeforeSwap));
+    EXPECT_THAT(cv::countNonZero(channels[0] != 30), Eq(0));
+    ASSERT_THAT(cv::countNonZero(channels[2] != 10), Eq(0));
+}
+INSTANTIATE_TEST_SUITE_P(QCVimg_BulkTest, QCVimgSwapMatRedBlue, ValuesIn(swapRedBlueCases));
+
+TEST(QCVimgSwapMatRedBlueFormat, VaryingPixelsMatchCvtColorForAllWidths)
+{
+    for (int width : {1, 6, 11, 21, 67}) {
+        cv::Mat sourceMat(3, width, CV_8UC3), destMat, expectedMat;
+        cv::randu(sourceMat, cv::Scalar::all(0), cv::Scalar::all(256));
+        cv::cvtColor(sourceMat, expectedMat, cv::COLOR_BGR2RGB);
+
+        QCVimg::swapMatRedBlue(sourceMat, destMat);
+        QCVimg::swapMatRedBlue(sourceMat, sourceMat);
+
+        EXPECT_THAT(cv::norm(destMat, expectedMat, cv::NORM_INF), Eq(0));
+        EXPECT_THAT(cv::norm(sourceMat, expectedMat, cv::NORM_INF), Eq(0));
+    }
+}
+
+TEST(QCVimgSwapMatRedBlueFormat, ReturnsErrorOnSingleChannelImage)
+{
+    cv::Mat sourceMat(4, 4, CV_8UC1), destMat;
+
+    ASSERT_THAT(QCVimg::swapMatRedBlue(sourceMat, destMat), Eq(-1));
+}
+
+struct QCVimgRegionView : public Test
+{
+    void SetUp() override {
+        img = QCVimg(originalWidth, originalHeight, QImage::Format_RGB888);
+        img.fill(originalColor);
+    }
+
+    QCVimg img;
+    QRect viewRect = QRect(3, 2, 5, 4);
+    QColor originalColor = qRgb(10, 20, 30), modifiedColor = qRgb(200, 150, 100);
+    int originalWidth = 16, originalHeight = 12;
+};
+
+TEST_F(QCVimgRegionView, ViewPointsIntoParentData)
+{
+    QCVimgView view = img.view(viewRect);
+
+    auto expectedDataPtr = img.qImg().constScanLine(viewRect.y()) + viewRect.x() * 3;
+
+    EXPECT_THAT(view.qImg().constBits(), Eq(expectedDataPtr));
+    EXPECT_THAT(view.cvMat().data, Eq(expectedDataPtr));
+    ASSERT_THAT(view.qImg().bytesPerLine(), Eq(img.qImg().bytesPerLine()));
+}
+
+TEST_F(QCVimgRegionView, ViewHasSizeOfRegion)
+{
+    QCVimgView view = img.view(viewRect);
+
+    EXPECT_THAT(view.width(), Eq(viewRect.width()));
+    EXPECT_THAT(view.height(), Eq(viewRect.height()));
+    EXPECT_THAT(view.cvMat().cols, Eq(viewRect.width()));
+    ASSERT_THAT(view.cvMat().rows, Eq(viewRect.height()));
+}
+
+TEST_F(QCVimgRegionView, ModificationThroughMatIsVisibleInParent)
+{
+    QCVimgView view = img.view(viewRect);
+
+    view.cvMat().setTo(QCVimg::convertQColorToScalar(modifiedColor, MatColorOrder::RGB));
+
+    EXPECT_THAT(img.pixelColor(viewRect.x(), viewRect.y()).rgb(), Eq(modifiedColor.rgb()));
+    ASSERT_THAT(img.pixelColor(viewRect.x() - 1, viewRect.y()).rgb(), Eq(originalColor.rgb()));
+}
+
+TEST_F(QCVimgRegionView, ModificationThroughQImageIsVisibleInParent)
+{
+    QCVimgView view = img.view(viewRect);
+
+    view.qImg().fill(modifiedColor);
+
+    ASSERT_THAT(img.pixelColor(viewRect.right(), viewRect.bottom()).rgb(), Eq(modifiedColor.rgb()));
+}
+
+TEST_F(QCVimgRegionView, RegionIsClippedToImageBoundaries)
+{
+    QCVimgView view = img.view(QRect(10, 10, 20, 20));
+
+    ASSERT_THAT(view.rect(), Eq(QRect(10, 10, 6, 2)));
+}
+
+TEST_F(QCVimgRegionView, RegionOutsideOfImageGivesEmptyView)
+{
+    QCVimgView view = img.view(QRect(100, 100, 5, 5));
+
+    ASSERT_TRUE(view.empty());
+}
+
+struct QCVimgDirtyRegion : public Test
+{
+    void SetUp() override {
+        img.fill(QColor(10, 20, 30));
+        img.clearDirty();
+    }
+
+    QCVimg img{32, 24, QImage::Format_RGB32};
+    QRect imageRect = QRect(0, 0, 32, 24);
+    QRect overlayRect = QRect(4, 6, 8, 5);
+};
+
+TEST_F(QCVimgDirtyRegion, RegionFillOnlyMarksFilledRect)
+{
+    img.fill(QColor(200, 0, 0), overlayRect);
+
+    ASSERT_THAT(img.dirtyRegion(), Eq(QRegion(overlayRect)));
+}
+
+TEST_F(QCVimgDirtyRegion, WholeImageFillMarksWholeImage)
+{
+    img.fill(QColor(200, 0, 0));
+
+    ASSERT_THAT(img.dirtyRegion(), Eq(QRegion(imageRect)));
+}
+
+TEST_F(QCVimgDirtyRegion, ClearDirtyEmptiesRegion)
+{
+    img.markDirty(overlayRect);
+
+    img.clearDirty();
+
+    ASSERT_TRUE(img.dirtyRegion().isEmpty());
+}
+
+TEST_F(QCVimgDirtyRegion, AccessorsDoNotMarkRegionUntilMarkDirty)
+{
+    img.cvMat().at<cv::Vec4b>(0, 0) = cv::Vec4b(1, 2, 3, 255);
+    img.scanLine<QCVimgPixel::ARGB32>(1)[0] = qRgb(4, 5, 6);
+
+    EXPECT_TRUE(img.dirtyRegion().isEmpty());
+    img.markDirty();
+    ASSERT_THAT(img.dirtyRegion(), Eq(QRegion(imageRect)));
+}
+
+TEST_F(QCVimgDirtyRegion, MutableBitsMarksWholeImage)
+{
+    img.mutableBits()[0] = 1;
+
+    ASSERT_THAT(img.dirtyRegion(), Eq(QRegion(imageRect)));
+}
+
+TEST_F(QCVimgDirtyRegion, ViewAndMarkDirtyAddUpRegions)
+{
+    QRect markedRect(20, 20, 30, 30);
+
+    img.view(overlayRect);
+    img.markDirty(markedRect);
+
+    ASSERT_THAT(img.dirtyRegion(), Eq(QRegion(overlayRect) + (markedRect & imageRect)));
+}
+
+struct QCVimgGeneration : public Test
+{
+    QCVimg img{8, 8, QImage::Format_Grayscale8};
+};
+
+TEST_F(QCVimgGeneration, ConstAccessKeepsGeneration)
+{
+    const QCVimg& constImg = img;
+    auto generationBefore = img.generation();
+
+    constImg.qImg();
+    constImg.cvMat();
+    constImg.hash();
+
+    ASSERT_THAT(img.generation(), Eq(generationBefore));
+}
+
+TEST_F(QCVimgGeneration, ModificationsChangeGeneration)
+{
+    auto generationBefore = img.generation();
+    img.fill(Qt::white);
+    auto generationAfterFill = img.generation();
+
+    img.cvMat();
+
+    EXPECT_THAT(generationAfterFill, Ne(generationBefore));
+    ASSERT_THAT(img.generation(), Ne(generationAfterFill));
+}
+
+TEST_F(QCVimgGeneration, RowAccessorsKeepGeneration)
+{
+    auto generationBefore = img.generation();
+
+    for (int y = 0; y < img.height(); ++y) {
+        img.scanLine<QCVimgPixel::Gray8>(y);
+    }
+
+    ASSERT_THAT(img.generation(), Eq(generationBefore));
+}
+
+TEST_F(QCVimgGeneration, WritesReportedWithMarkDirtyUpdateCachedHash)
+{
+    img.fill(Qt::black);
+    const size_t hashBeforeWrite = img.hash(HashCaching::Enabled);
+
+    img.cvMat().at<uchar>(3, 3) = 200;
+    img.markDirty(QRect(3, 3, 1, 1));
+
+    ASSERT_THAT(img.hash(HashCaching::Enabled), Ne(hashBeforeWrite));
+}
+
+TEST_F(QCVimgGeneration, WritesThroughMatAccessorUpdateCachedHash)
+{
+    img.fill(Qt::black);
+    const size_t hashBeforeWrite = img.hash(HashCaching::Enabled);
+
+    img.cvMat().at<uchar>(3, 3) = 200;
+
+    ASSERT_THAT(img.hash(HashCaching::Enabled), Ne(hashBeforeWrite));
+}
+
+TEST_F(QCVimgGeneration, MoveAssignmentDoesNotGoBackInGeneration)
+{
+    img.fill(Qt::white);
+    img.fill(Qt::black);
+    auto generationBefore = img.generation();
+
+    img = QCVimg(8, 8, QImage::Format_Grayscale8);
+
+    ASSERT_THAT(img.generation(), Gt(generationBefore));
+}
+
+struct QCVimgPixelAccess : public Test
+{
+    void SetUp() override {
+        img.fill(QColor(10, 20, 30));
+    }
+
+    QCVimg img{7, 5, QImage::Format_RGB888};
+};
+
+TEST_F(QCVimgPixelAccess, ScanLinePointsIntoRow)
+{
+    const QCVimg& constImg = img;
+
+    const QCVimgPixel::RGB888* line = constImg.scanLine<QCVimgPixel::RGB888>(3);
+
+    EXPECT_THAT(reinterpret_cast<const uchar*>(line), Eq(img.qImg().constScanLine(3)));
+    ASSERT_THAT(line[2].g, Eq(20));
+}
+
+TEST_F(QCVimgPixelAccess, WritingThroughScanLineIsVisibleInBothMembers)
+{
+    img.scanLine<QCVimgPixel::RGB888>(1)[4] = {200, 150, 100};
+
+    EXPECT_THAT(img.pixelColor(4, 1), Eq(QColor(200, 150, 100)));
+    ASSERT_THAT(img.cvMat().at<cv::Vec3b>(1, 4), Eq(cv::Vec3b(200, 150, 100)));
+}
+
+TEST_F(QCVimgPixelAccess, RowsCoverWholeImage)
+{
+    int rowCount = 0;
+    int pixelCount = 0;
+
+    for (QCVimgSpan<const QCVimgPixel::RGB888> row : static_cast<const QCVimg&>(img).rows<QCVimgPixel::RGB888>()) {
+        ++rowCount;
+        for (const QCVimgPixel::RGB888& pixel : row) {
+            pixelCount += pixel.b == 30 ? 1 : 0;
+        }
+    }
+
+    EXPECT_THAT(rowCount, Eq(img.height()));
+    ASSERT_THAT(pixelCount, Eq(img.width() * img.height()));
+}
+
+TEST_F(QCVimgPixelAccess, ForEachPixelModifiesAllPixels)
+{
+    img.forEachPixel<QCVimgPixel::RGB888>([](QCVimgPixel::RGB888& pixel) { pixel.r = 255; });
+
+    EXPECT_THAT(img.pixelColor(0, 0), Eq(QColor(255, 20, 30)));
+    ASSERT_THAT(img.pixelColor(6, 4), Eq(QColor(255, 20, 30)));
+}
+
+TEST_F(QCVimgPixelAccess, ParallelForEachPixelPassesCoordinates)
+{
+    QCVimg grayImg(64, 48, QImage::Format_Grayscale8);
+
+    grayImg.forEachPixel<QCVimgPixel::Gray8>([](uchar& pixel, int x, int y) { pixel = uchar(x + y); },
+                                             PixelExecution::Parallel);
+
+    EXPECT_THAT(grayImg.cvMat().at<uchar>(0, 0), Eq(0));
+    ASSERT_THAT(grayImg.cvMat().at<uchar>(47, 63), Eq(110));
+}
+
+TEST_F(QCVimgPixelAccess, WritingThroughScanLineDoesNotChangeSharedHandle)
+{
+    QCVimgConstRef handle = img.share();
+
+    img.scanLine<QCVimgPixel::RGB888>(0)[0] = {1, 2, 3};
+
+    ASSERT_THAT(handle.qImg().pixelColor(0, 0), Eq(QColor(10, 20, 30)));
+}
+
+struct QCVimgExecutionContext : public Test
+{
+    void SetUp() override {
+        pool.setMaxThreadCount(2);
+        img.fill(QColor(10, 20, 30));
+    }
+
+    QThreadPool pool;
+    QCVimg img{64, 48, QImage::Format_RGB888};
+};
+
+TEST_F(QCVimgExecutionContext, ScopeInstallsAndRestoresContext)
+{
+    {
+        QCVimgExecution::Scope scope(QCVimgExecution::threads(3));
+
+        EXPECT_THAT(QCVimgExecution::current().maxThreads(), Eq(3));
+    }
+
+    ASSERT_TRUE(QCVimgExecution::current().isDefault());
+}
+
+TEST_F(QCVimgExecutionContext, SerialContextRunsWholeRangeAtOnce)
+{
+    std::vector<cv::Range> stripes;
+
+    QCVimgExecution::serial().parallelFor(cv::Range(0, 100), [&](const cv::Range& range) {
+        stripes.push_back(range);
+    });
+
+    EXPECT_THAT(stripes.size(), Eq(1u));
+    ASSERT_TRUE(stripes.front() == cv::Range(0, 100));
+}
+
+TEST_F(QCVimgExecutionContext, PoolContextSplitsRangeIntoMaxThreadsStripes)
+{
+    std::atomic<int> stripeCount{0}, coveredCount{0}, nestedSerialCount{0};
+
+    QCVimgExecution::onPool(&pool, 3).parallelFor(cv::Range(0, 100), [&](const cv::Range& range) {
+        ++stripeCount;
+        coveredCount += range.size();
+        nestedSerialCount += QCVimgExecution::current().maxThreads() == 1 ? 1 : 0;
+    });
+
+    EXPECT_THAT(stripeCount.load(), Eq(3));
+    EXPECT_THAT(coveredCount.load(), Eq(100));
+    ASSERT_THAT(nestedSerialCount.load(), Eq(3));
+}
+
+TEST_F(QCVimgExecutionContext, ConversionWithinContextMatchesDefaultConversion)
+{
+    QCVimg expectedImg = img.convertToFormat(QImage::Format_ARGB32);
+    QCVimgExecution::Scope scope(QCVimgExecution::onPool(&pool));
+
+    QCVimg convertedImg = img.convertToFormat(QImage::Format_ARGB32);
+
+    ASSERT_TRUE(convertedImg == expectedImg);
+}
+
+TEST_F(QCVimgExecutionContext, FillAndSwapWithinSerialContext)
+{
+    QCVimgExecution::Scope scope(QCVimgExecution::serial());
+
+    img.fill(QColor(1, 2, 3));
+    QCVimg::swapMatRedBlue(img.cvMat(), img.cvMat());
+
+    ASSERT_THAT(img.pixelColor(63, 47), Eq(QColor(3, 2, 1)));
+}
+
+struct QCVimgImagePyramid : public Test
+{
+    void SetUp() override {
+        img.fill(QColor(40, 80, 120));
+    }
+
+    QCVimgCore img{64, 48, QImage::Format_RGB888};
+};
+
+TEST_F(QCVimgImagePyramid, LevelsHalveTheSize)
+{
+    QCVimgPyramid pyramid = img.pyramid(4);
+
+    EXPECT_THAT(pyramid.levelCount(), Eq(4));
+    EXPECT_THAT(pyramid.level(1).width(), Eq(32));
+    EXPECT_THAT(pyramid.level(2).height(), Eq(12));
+    ASSERT_THAT(pyramid.level(3).qFormat(), Eq(QImage::Format_RGB888));
+}
+
+TEST_F(QCVimgImagePyramid, LevelCountStopsAtSinglePixel)
+{
+    QCVimgCore smallImg(5, 3, QImage::Format_Grayscale8);
+    QCVimgPyramid pyramid = smallImg.pyramid(10);
+
+    EXPECT_THAT(pyramid.levelCount(), Eq(4));
+    ASSERT_THAT(pyramid.levelSize(3), Eq(QSize(1, 1)));
+}
+
+TEST_F(QCVimgImagePyramid, UniformImageKeepsColorOnAllLevels)
+{
+    QCVimgPyramid gaussianPyramid = img.pyramid(3);
+    QCVimgPyramid boxPyramid = img.pyramid(3, PyramidFilter::Box);
+
+    EXPECT_THAT(gaussianPyramid.level(2).qImg().pixelColor(7, 5), Eq(QColor(40, 80, 120)));
+    ASSERT_THAT(boxPyramid.level(2).qImg().pixelColor(7, 5), Eq(QColor(40, 80, 120)));
+}
+
+TEST_F(QCVimgImagePyramid, ModifyingSourceRebuildsLevels)
+{
+    QCVimgPyramid pyramid = img.pyramid(2, PyramidFilter::Box);
+    pyramid.update();
+
+    img.fill(QColor(1, 2, 3));
+
+    EXPECT_TRUE(pyramid.isStale());
+    ASSERT_THAT(pyramid.level(1).qImg().pixelColor(0, 0), Eq(QColor(1, 2, 3)));
+}
+
+TEST_F(QCVimgImagePyramid, HandedOutLevelSurvivesRebuild)
+{
+    QCVimgPyramid pyramid = img.pyramid(2, PyramidFilter::Box);
+    const QCVimgConstRef oldLevel = pyramid.level(1);
+
+    img.fill(QColor(1, 2, 3));
+    const QCVimgConstRef newLevel = pyramid.level(1);
+
+    EXPECT_THAT(oldLevel.qImg().pixelColor(0, 0), Eq(QColor(40, 80, 120)));
+    ASSERT_THAT(newLevel.qImg().pixelColor(0, 0), Eq(QColor(1, 2, 3)));
+}
+
+TEST_F(QCVimgImagePyramid, RebuildReusesUnreferencedBuffer)
+{
+    QCVimgPyramid pyramid = img.pyramid(3);
+    const uchar* levelData = pyramid.level(2).qImg().constBits();
+
+    img.fill(QColor(1, 2, 3));
+
+    ASSERT_THAT(pyramid.level(2).qImg().constBits(), Eq(levelData));
+}
+
+TEST_F(QCVimgImagePyramid, LevelForScalePicksSmallestSufficientLevel)
+{
+    QCVimgPyramid pyramid = img.pyramid(4);
+
+    EXPECT_THAT(pyramid.levelForScale(1.0), Eq(0));
+    EXPECT_THAT(pyramid.levelForScale(0.3), Eq(1));
+    ASSERT_THAT(pyramid.levelForScale(0.01), Eq(3));
+}
+
+struct QCVimgFrameStore : public Test
+{
+    void SetUp() override {
+        for (int i = 0; i < 5; ++i) {
+            QCVimgCore frame(20, 10, QImage::Format_RGB888);
+            frame.fill(QColor(10, 20, 30));
+            frame.fill(QColor(200, 100, i * 40), QRect(i * 2, 3, 4, 4));
+            frames.push_back(std::move(frame));
+        }
+    }
+
+    bool matches(const QCVimgConstRef& storedFrame, const QCVimgCore& frame) const {
+        return !storedFrame.empty() && cv::norm(storedFrame.cvMat(), frame.cvMat(), cv::NORM_INF) == 0;
+    }
+
+    std::vector<QCVimgCore> frames;
+};
+
+TEST_F(QCVimgFrameStore, DeltaFramesDecodeToOriginals)
+{
+    QCVimgStore store(0, 3);
+
+    for (const auto& frame : frames) {
+        store.append(frame);
+    }
+
+    EXPECT_THAT(store.count(), Eq(5));
+    EXPECT_TRUE(matches(store.frame(4), frames[4]));
+    EXPECT_TRUE(matches(store.frame(0), frames[0]));
+    ASSERT_TRUE(matches(store.frame(2), frames[2]));
+}
+
+TEST_F(QCVimgFrameStore, FramesAreCompressed)
+{
+    QCVimgStore store;
+
+    for (const auto& frame : frames) {
+        store.append(frame);
+    }
+
+    EXPECT_THAT(store.uncompressedBytes(), Eq(5 * 20 * 10 * 3));
+    ASSERT_LT(store.compressedBytes(), store.uncompressedBytes());
+}
+
+TEST_F(QCVimgFrameStore, CapacityDropsOldestFramesKeepingRestDecodable)
+{
+    QCVimgStore store(3, 30, 1);
+
+    for (const auto& frame : frames) {
+        store.append(frame);
+    }
+
+    EXPECT_THAT(store.count(), Eq(3));
+    EXPECT_TRUE(matches(store.frame(0), frames[2]));
+    ASSERT_TRUE(matches(store.frame(2), frames[4]));
+}
+
+TEST_F(QCVimgFrameStore, FormatChangeStartsNewKeyFrame)
+{
+    QCVimgStore store;
+    QCVimgCore grayFrame(20, 10, QImage::Format_Grayscale8);
+    grayFrame.fill(QColor(50, 50, 50));
+
+    store.append(frames[0]);
+    store.append(grayFrame);
+
+    EXPECT_THAT(store.frame(1).qFormat(), Eq(QImage::Format_Grayscale8));
+    ASSERT_TRUE(matches(store.frame(1), grayFrame));
+}
+
+TEST_F(QCVimgFrameStore, InvalidFramesAndIndicesAreRejected)
+{
+    QCVimgStore store;
+
+    EXPECT_THAT(store.append(QCVimgCore()), Eq(-1));
+    EXPECT_TRUE(store.frame(0).empty());
+    store.append(frames[0]);
+    ASSERT_TRUE(store.frame(1).empty());
+}
+
+struct QCVimgFrameHandoff : public Test
+{
+    QCVimgCore createFrame(int value) const {
+        QCVimgCore frame(8, 4, QImage::Format_Grayscale8);
+        frame.fill(QColor(value, value, value));
+        return frame;
+    }
+};
+
+TEST_F(QCVimgFrameHandoff, QueuePopsInPushOrderWithoutCopying)
+{
+    QCVimgQueue queue(4);
+    QCVimgCore firstFrame = createFrame(1);
+    const uchar* firstData = firstFrame.cvMat().data;
+    QCVimgCore poppedFrame;
+
+    queue.tryPush(std::move(firstFrame));
+    queue.tryPush(createFrame(2));
+
+    EXPECT_THAT(queue.size(), Eq(2));
+    EXPECT_TRUE(queue.tryPop(poppedFrame));
+    EXPECT_THAT(poppedFrame.cvMat().data, Eq(firstData));
+    EXPECT_TRUE(queue.tryPop(poppedFrame));
+    EXPECT_THAT(poppedFrame.pixelColor(0, 0), Eq(QColor(2, 2, 2)));
+    ASSERT_FALSE(queue.tryPop(poppedFrame));
+}
+
+TEST_F(QCVimgFrameHandoff, FullQueueLeavesImageUnchanged)
+{
+    QCVimgQueue queue(2);
+    QCVimgCore frame = createFrame(3);
+
+    queue.tryPush(createFrame(1));
+    queue.tryPush(createFrame(2));
+
+    EXPECT_THAT(queue.capacity(), Eq(2));
+    EXPECT_FALSE(queue.tryPush(std::move(frame)));
+    ASSERT_THAT(frame.pixelColor(0, 0), Eq(QColor(3, 3, 3)));
+}
+
+TEST_F(QCVimgFrameHandoff, QueueReleasesPoppedOverFrame)
+{
+    QCVimgQueue queue(2);
+    QCVimgCore poppedFrame = createFrame(1);
+    const QImage previousData = std::as_const(poppedFrame).qImg();
+
+    queue.tryPush(createFrame(2));
+    queue.tryPop(poppedFrame);
+
+    EXPECT_THAT(poppedFrame.pixelColor(0, 0), Eq(QColor(2, 2, 2)));
+    ASSERT_TRUE(previousData.isDetached());
+}
+
+TEST_F(QCVimgFrameHandoff, QueuePassesAllFramesBetweenThreads)
+{
+    const int frameCount = 200;
+    QCVimgQueue queue(8);
+    int receivedCount = 0;
+    bool ordered = true;
+
+    std::thread producer([&] {
+        for (int i = 0; i < frameCount; ++i) {
+            QCVimgCore frame = createFrame(i % 256);
+
+            while (!queue.tryPush(std::move(frame))) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    QCVimgCore frame;
+
+    while (receivedCount < frameCount) {
+        if (queue.tryPop(frame)) {
+            ordered = ordered && frame.pixelColor(7, 3).red() == receivedCount % 256;
+            ++receivedCount;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+
+    EXPECT_TRUE(ordered);
+    ASSERT_TRUE(queue.empty());
+}
+
+TEST_F(QCVimgFrameHandoff, TripleBufferHandsOverLatestFrame)
+{
+    QCVimgTripleBuffer buffer;
+
+    EXPECT_FALSE(buffer.update());
+    buffer.publish(createFrame(1));
+    buffer.publish(createFrame(2));
+
+    EXPECT_TRUE(buffer.update());
+    EXPECT_THAT(buffer.front().pixelColor(0, 0), Eq(QColor(2, 2, 2)));
+    ASSERT_FALSE(buffer.update());
+}
+
+TEST_F(QCVimgFrameHandoff, TripleBufferReleasesReplacedBackImage)
+{
+    QCVimgTripleBuffer buffer;
+    buffer.back() = createFrame(1);
+    const QImage previousData = std::as_const(buffer.back()).qImg();
+    QCVimgCore frame = createFrame(2);
+
+    buffer.publish(std::move(frame));
+
+    EXPECT_TRUE(frame.empty());
+    ASSERT_TRUE(previousData.isDetached());
+}
+
+TEST_F(QCVimgFrameHandoff, TripleBufferRecyclesFetchedImages)
+{
+    QCVimgTripleBuffer buffer;
+
+    buffer.publish(createFrame(1));
+    buffer.update();
+    const uchar* frontData = buffer.front().cvMat().data;
+    buffer.publish(createFrame(2));
+    buffer.update();
+    buffer.publish(createFrame(3));
+
+    ASSERT_THAT(buffer.back().cvMat().data, Eq(frontData));
+}
+
+#ifdef QT_MULTIMEDIA_LIB
+struct QCVimgVideoImport : public Test
+{
+    void SetUp() override {
+        cv::randu(yuyvMat, cv::Scalar::all(0), cv::Scalar::all(256));
+        cv::randu(nv12Mat, cv::Scalar::all(0), cv::Scalar::all(256));
+    }
+
+    const int width = 16;
+    const int height = 8;
+    cv::Mat yuyvMat{height, width, CV_8UC2};
+    cv::Mat nv12Mat{height * 3 / 2, width, CV_8UC1};
+};
+
+TEST_F(QCVimgVideoImport, PackedConversionMatchesOpenCV)
+{
+    const uchar* planes[2] = {yuyvMat.data, nullptr};
+    const int bytesPerLine[2] = {static_cast<int>(yuyvMat.step), 0};
+    QCVimgCore img;
+    cv::Mat expectedMat;
+
+    cv::cvtColor(yuyvMat, expectedMat, cv::COLOR_YUV2RGB_YUYV);
+
+    EXPECT_THAT(QCVimgVideo::convertYuv(QCVimgVideo::YuvLayout::YUYV, planes, bytesPerLine, width, height, img), Eq(0));
+    EXPECT_THAT(img.qFormat(), Eq(QImage::Format_RGB888));
+    ASSERT_THAT(cv::norm(img.cvMat(), expectedMat, cv::NORM_INF), Eq(0));
+}
+
+TEST_F(QCVimgVideoImport, TwoPlaneConversionMatchesOpenCV)
+{
+    const uchar* planes[2] = {nv12Mat.data, nv12Mat.ptr(height)};
+    const int bytesPerLine[2] = {width, width};
+    QCVimgCore img;
+    cv::Mat expectedMat;
+
+    cv::cvtColor(nv12Mat, expectedMat, cv::COLOR_YUV2BGRA_NV12);
+
+    EXPECT_THAT(QCVimgVideo::convertYuv(QCVimgVideo::YuvLayout::NV12, planes, bytesPerLine, width, height, img,
+                                        QImage::Format_RGB32), Eq(0));
+    ASSERT_THAT(cv::norm(img.cvMat(), expectedMat, cv::NORM_INF), Eq(0));
+}
+
+TEST_F(QCVimgVideoImport, NeutralChromaGivesGray)
+{
+    yuyvMat = cv::Scalar::all(128);
+    const uchar* planes[2] = {yuyvMat.data, nullptr};
+    const int bytesPerLine[2] = {static_cast<int>(yuyvMat.step), 0};
+    QCVimgCore img;
+
+    QCVimgVideo::convertYuv(QCVimgVideo::YuvLayout::UYVY, planes, bytesPerLine, width, height, img);
+    const QColor color = img.pixelColor(width - 1, height - 1);
+
+    EXPECT_THAT(color.red(), Eq(color.green()));
+    ASSERT_THAT(color.green(), Eq(color.blue()));
+}
+
+TEST_F(QCVimgVideoImport, ConversionReusesMatchingDestination)
+{
+    const uchar* planes[2] = {yuyvMat.data, nullptr};
+    const int bytesPerLine[2] = {static_cast<int>(yuyvMat.step), 0};
+    QCVimgCore img(width, height, QImage::Format_RGB888);
+    const uchar* matDataPtr = img.cvMat().data;
+
+    QCVimgVideo::convertYuv(QCVimgVideo::YuvLayout::YUYV, planes, bytesPerLine, width, height, img);
+
+    ASSERT_THAT(img.cvMat().data, Eq(matDataPtr));
+}
+
+TEST_F(QCVimgVideoImport, InvalidSizeOrFormatFails)
+{
+    const uchar* planes[2] = {nv12Mat.data, nv12Mat.ptr(height)};
+    const int bytesPerLine[2] = {width, width};
+    QCVimgCore img;
+
+    EXPECT_THAT(QCVimgVideo::convertYuv(QCVimgVideo::YuvLayout::NV12, planes, bytesPerLine, width - 1, height, img), Eq(-1));
+    EXPECT_THAT(QCVimgVideo::convertYuv(QCVimgVideo::YuvLayout::NV12, planes, bytesPerLine, width, height, img,
+                                        QImage::Format_Grayscale8), Eq(-1));
+    ASSERT_TRUE(img.empty());
+}
+#endif
+
+struct QCVimgAsync : public Test
+{
+    void SetUp() override {
+        img.fill(originalColor);
+    }
+
+    QCVimgCore img{24, 16, QImage::Format_RGB888};
+    QColor originalColor = QColor(20, 40, 60);
+};
+
+TEST_F(QCVimgAsync, AsyncConversionMatchesSynchronousConversion)
+{
+    QFuture<QCVimgConstRef> future = img.convertToFormatAsync(QImage::Format_ARGB32);
+
+    QCVimgCore converted = future.result().copy();
+
+    ASSERT_TRUE(converted == img.convertToFormat(QImage::Format_ARGB32));
+}
+
+TEST_F(QCVimgAsync, ModifyingSourceDuringAsyncResizeDoesNotAffectResult)
+{
+    QFuture<QCVimgConstRef> future = img.resizeAsync(12, 8);
+    img.fill(Qt::red);
+
+    QCVimgConstRef resized = future.result();
+
+    EXPECT_THAT(resized.width(), Eq(12));
+    ASSERT_THAT(resized.qImg().pixelColor(3, 3), Eq(originalColor));
+}
+
+TEST_F(QCVimgAsync, PipelineRunsAllStagesOnEveryFrameInOrder)
+{
+    QCVimgPipeline pipeline;
+    pipeline.convert(QImage::Format_Grayscale8).resize(6, 4);
+    std::vector<QFuture<QCVimgConstRef>> futures;
+
+    for (int frame = 0; frame < 5; ++frame) {
+        QCVimgCore frameImg(24, 16, QImage::Format_RGB888);
+        frameImg.fill(QColor(frame * 10, frame * 10, frame * 10));
+        futures.push_back(pipeline.process(std::move(frameImg)));
+    }
+
+    pipeline.waitForDone();
+
+    EXPECT_THAT(pipeline.stageCount(), Eq(2));
+
+    for (int frame = 0; frame < 5; ++frame) {
+        QCVimgConstRef result = futures[frame].result();
+        EXPECT_THAT(result.qFormat(), Eq(QImage::Format_Grayscale8));
+        EXPECT_THAT(result.qImg().size(), Eq(QSize(6, 4)));
+        EXPECT_THAT(result.cvMat().at<uchar>(1, 1), Eq(frame * 10));
+    }
+}
+
+TEST_F(QCVimgAsync, PipelineLeavesSharedSourceFrameUnchanged)
+{
+    QCVimgPipeline pipeline;
+    pipeline.swizzle();
+
+    QCVimgConstRef result = pipeline.process(img).result();
+
+    EXPECT_THAT(result.qImg().pixelColor(1, 1), Eq(QColor(60, 40, 20)));
+    ASSERT_THAT(img.pixelColor(1, 1), Eq(originalColor));
+}
+
+struct QCVimgLoadSave : public Test
+{
+    void SetUp() override {
+        file.open();
+        file.close();
+        sourceImg.fill(QColor(10, 200, 30));
+        sourceImg.save(file.fileName(), "png");
+    }
+
+    QTemporaryFile file;
+    QCVimgCore sourceImg{9, 5, QImage::Format_RGB32};
+};
+
+TEST_F(QCVimgLoadSave, LoadedImageMatchesSavedImage)
+{
+    QCVimgCore img;
+
+    int returnCode = img.load(file.fileName(), "png");
+
+    EXPECT_THAT(returnCode, Eq(0));
+    EXPECT_TRUE(img.isMatBound());
+    ASSERT_THAT(img.pixelColor(4, 2), Eq(QColor(10, 200, 30)));
+}
+
+TEST_F(QCVimgLoadSave, LoadReusesBufferOfMatchingImage)
+{
+    QCVimgCore img;
+    img.load(file.fileName(), "png");
+    auto dataPtr = img.qImg().constBits();
+
+    img.load(file.fileName(), "png");
+
+    EXPECT_THAT(img.qImg().constBits(), Eq(dataPtr));
+    ASSERT_THAT(img.cvMat().data, Eq(dataPtr));
+}
+
+TEST_F(QCVimgLoadSave, ReaderDecodesIntoPooledBuffer)
+{
+    QCVimgPool pool;
+    QCVimgReader reader(file.fileName(), "png");
+    reader.setPool(&pool);
+
+    QCVimg img = reader.read();
+
+    EXPECT_TRUE(img.isMatBound());
+    ASSERT_THAT(reinterpret_cast<quintptr>(img.qImg().constBits()) % QCVimgPool::scmBufferAlignment, Eq(0u));
+}
+
+TEST_F(QCVimgLoadSave, LoadingMissingFileLeavesImageEmpty)
+{
+    QCVimgCore img{4, 4, QImage::Format_Grayscale8};
+
+    int returnCode = img.load(file.fileName() + ".missing");
+
+    EXPECT_THAT(returnCode, Eq(-1));
+    ASSERT_TRUE(img.empty());
+}
+
+TEST(QCVimgReaderFormat, HighBitDepthFormatsKeepTheirPrecision)
+{
+    EXPECT_THAT(QCVimgReader::compatibleFormat(QImage(2, 2, QImage::Format_RGBA64_Premultiplied)),
+                Eq(QImage::Format_RGBA64));
+    EXPECT_THAT(QCVimgReader::compatibleFormat(QImage(2, 2, QImage::Format_RGB30)), Eq(QImage::Format_RGBX64));
+    ASSERT_THAT(QCVimgReader::compatibleFormat(QImage(2, 2, QImage::Format_ARGB8565_Premultiplied)),
+                Eq(QImage::Format_ARGB32));
+}